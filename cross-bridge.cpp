@@ -48,7 +48,7 @@ person, which minimizes all the return journeys.  In addition, it doesn't matter
 what order the pairs cross the bridge, so no sorting is required. This algorithm
 runs in O(N), taking one pass through all the people to find the fastest person,
 then another pass to send the pairs across the bridge.  However, it doesn't
-always yield the fastest time.  This is implemented by Bridge::crossNaively()
+always yield the fastest time.  This is implemented by Bridge::naiveTotal()
 
 The Shielding Method:  The optimal solution is to let the slowest and second
 slowest cross together, then send back one of the fastest people.  This
@@ -59,7 +59,7 @@ pairing the slowest with the fastest, then the second slowest with the fastest.
 After the two slowest people are across, start over with the remaining people.
 This strategy requires sorting the people and then making a pass through the
 people, two at a time.  This is about NlogN + N which is O(NlogN), much better
-than the brute force approach.  This is implemented by Bridge::crossOptimally()
+than the brute force approach.  This is implemented by Bridge::planOptimally()
 
 Assumptions:
 
@@ -74,16 +74,63 @@ Implementation summary:
 
 This C++11 code depends on the yaml-cpp library.
 
-There are three Classes:
+There are twenty-five Classes:
 
 1. The Arguments class is used to read command line arguments.
 
-2. The Person class is used to store information about each person waiting to
+2. The NamePool class stores each distinct name once, in a bump arena.
+
+3. The Stats class collects the --stats report; PhaseTimer times one phase,
+PerfCounters reads the hardware counters and CountingStreambuf counts the
+bytes written to std::cout.
+
+4. The MappedFile class maps an input file into memory for the fast parsers.
+
+5. The BufferedWriter class collects output into large blocks before
+writing it.
+
+6. The JsonWriter class streams JSON to a BufferedWriter.
+
+7. The PeopleStream class reads people one at a time from standard input.
+
+8. The SpeedHistogram class counts streamed people by speed and computes the
+crossing totals from the counts.
+
+9. The ArrivalTree class keeps arriving people sorted by speed and maintains
+the running optimal total.
+
+10. The Partition class splits a roster across several bridges, each with its
+own torch, to minimize the makespan.
+
+11. The Person class is used to store information about each person waiting to
 cross the bridge.
 
-3. The Bridge class contains a vector of people waiting to cross the bridge, as
+12. The Schedule class holds the Shielding/Naive decision for each round and
+produces the crossing steps on demand.  The ScheduleRanking class produces
+the schedules with other round decisions, fastest first, and BigNatural
+holds the count of optimal schedules.
+
+13. The ScheduleEncoder class streams a schedule out in a compact binary
+format.
+
+14. The ScheduleDecoder class reads the binary format back.
+
+15. The CrossingStates class is the space of states the exact searches
+explore, counting the people of each speed on the near bank.  The
+CrossingSearch class checks the optimal total by branch and bound over every
+possible schedule, ParallelCrossingSearch does the same on many threads, each
+owning a shard of the states, and IdaCrossingSearch by iterative deepening in
+a fixed amount of memory.  ConstrainedPlan plans the crossings when some
+people start on the far bank or can't return, LoadPlan plans them for a
+bridge rated by load, and TorchPlan for several torches.  The pair costs
+MaxCost, PenaltyCost and TableCost give the time two people take together
+to CrossingStates and planPairRounds().
+
+16. The Bridge class contains a vector of people waiting to cross the bridge, as
 well as functions to implement each crossing method: Naive and Shielding.  There
-is also a function to read a YAML file of people into a vector.
+is also a function to read a YAML file of people into a vector.  Reading and
+solving print nothing; the text output is written by the write*() functions
+through a BufferedWriter, and --list-people adds the list of people.
 
 --- End Problem Discussion ---
 
@@ -93,23 +140,95 @@ Author:  Paul J. Nadolny
 
 Date        Ver  Comments
 2019 Jun 08 0.1  First version.
+2026 Oct 16 0.2  Template solvers for small fixed N, Bridge::optimalTotal().
+2026 Oct 16 0.3  Column-wise batch solver, --batch option.
+2026 Oct 17 0.4  NamePool arena with interning for Person names.
+2026 Oct 17 0.5  Parallel parsing of line-oriented roster dumps.
+2026 Oct 17 0.6  CSV / TSV roster input, --people-csv option.
+2026 Oct 17 0.7  Streaming standard input into a speed histogram.
+2026 Oct 17 0.8  Online arrival mode with a running optimal total, --online.
+2026 Oct 17 0.9  Compact Schedule of round decisions with lazy steps.
+2026 Oct 17 0.10 Binary schedule format, --schedule-out, --decode-schedule.
+2026 Oct 17 0.11 JSON and NDJSON results, --format, --schedule.
+2026 Oct 17 0.12 Per-phase timing and counters, --stats.
+2026 Oct 17 0.13 Hardware performance counters per phase, --perf-counters.
+2026 Oct 17 0.14 Silent reading, buffered text output, --list-people.
+2026 Oct 17 0.15 Makespan partition across several bridges, --bridges.
+2026 Oct 17 0.16 Torch lifetime, --torch-limit; exact search, --exact dfs.
+2026 Oct 17 0.17 Sharded multi-threaded exact search, --exact parallel.
+2026 Oct 17 0.18 Exact search states count people per speed class.
+2026 Oct 17 0.19 Iterative deepening exact search, --exact ida, --tt-size.
+2026 Oct 17 0.20 The k fastest schedules, --top-k.
+2026 Oct 17 0.21 Count the distinct optimal schedules, --count-optimal.
+2026 Oct 17 0.22 People who start on the far bank, bank: far.
+2026 Oct 17 0.23 People who can't make return trips, can_return: false.
+2026 Oct 17 0.24 Bridges rated by load, weight and --max-load.
+2026 Oct 17 0.25 Pair cost functors, --pair-penalty, --pair-table.
+2026 Oct 17 0.26 Several torches, --torches.
 
 To compile on macOS High Sierra 10.13.6:
 % export CPATH=~/homebrew/Cellar/yaml-cpp/0.6.2_1/include/
 % export LIBRARY_PATH=~/homebrew/Cellar/yaml-cpp/0.6.2_1/lib
-% g++ -std=c++11 -o cross-bridge cross-bridge.cpp -lyaml-cpp
+% g++ -std=c++11 -pthread -o cross-bridge cross-bridge.cpp -lyaml-cpp
+
+For --batch to run on SIMD lanes, g++ needs -O3 to vectorize:
+% g++ -std=c++11 -O3 -pthread -o cross-bridge cross-bridge.cpp -lyaml-cpp
 
 To run:
 % ./cross-bridge --people people.yaml
+% ./cross-bridge --people people.yaml --list-people
+% ./cross-bridge --people people.yaml --bridges 3
+% ./cross-bridge --people people.yaml --torches 2
+% ./cross-bridge --people people.yaml --top-k 5
+% ./cross-bridge --people people.yaml --count-optimal
+% ./cross-bridge --people people.yaml --max-load 250
+% ./cross-bridge --people people.yaml --pair-penalty 2 --exact dfs
+% ./cross-bridge --people people.yaml --torch-limit 60 --exact dfs
+% ./cross-bridge --people people.yaml --exact parallel --threads 32
+% ./cross-bridge --people people.yaml --exact ida --tt-size 256
+% ./cross-bridge --people-dump people.txt --threads 8
+% some-tool | ./cross-bridge --people -
+% some-tool | ./cross-bridge --people - --online
+% ./cross-bridge --people-csv people.csv
+% ./cross-bridge --people people.yaml --schedule-out schedule.xbs
+% ./cross-bridge --decode-schedule schedule.xbs
+% ./cross-bridge --people people.yaml --format json --schedule
+% ./cross-bridge --people people.yaml --stats
+% ./cross-bridge --people people.yaml --perf-counters
+% ./cross-bridge --batch rosters.yaml
 
 */
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <array>
+#include <map>
 #include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <iomanip>
 #include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
 
 #include <yaml-cpp/yaml.h>
 
@@ -118,15 +237,329 @@ To run:
 // ---------------------------------------------------------------------------
 const int DEBUG = 0;
 
+// Rosters up to this size are solved by the unrolled templates below
+const int SMALL_ROSTER_MAX = 16;
+
+// Person names are copied into blocks of this many bytes
+const std::size_t NAME_BLOCK_SIZE = 64 * 1024;
+
+// A roster dump smaller than this is parsed on a single thread
+const std::size_t PARALLEL_PARSE_MIN_BYTES = 1024 * 1024;
+
+// Bytes read from standard input at a time when streaming people
+const std::size_t STREAM_BUFFER_SIZE = 64 * 1024;
+
+// Bytes collected by a BufferedWriter before each write to the file
+const std::size_t WRITE_BUFFER_SIZE = 256 * 1024;
+
+// Hardware counters read around each phase with --perf-counters
+const int PERF_COUNTERS = 4;
+const char * const PERF_COUNTER_NAMES[PERF_COUNTERS] =
+  {"cycles", "instructions", "cache misses", "branch misses"};
+
+// Rosters up to this size are split across bridges by exhaustive search
+const int EXACT_PARTITION_MAX = 12;
+
+// Rosters with up to this many crossing states (2^(N+1) for N distinct
+// speeds, far fewer with repeated speeds) can be solved by exact search, by
+// --exact dfs and by --exact parallel
+const unsigned long long EXACT_SEARCH_STATES = 1ULL << 21;
+const unsigned long long PARALLEL_SEARCH_STATES = 1ULL << 25;
+
+// The lower bound on the time left from a state no schedule can finish,
+// such as three people on the near bank and no one able to return; small
+// enough that adding times to it can't overflow
+const long long UNREACHABLE_TIME = std::numeric_limits<long long>::max() / 4;
+
+// The first bytes of a binary schedule file, including the format version
+const char SCHEDULE_MAGIC[4] = {'X', 'B', 'S', '1'};
+
 // ---------------------------------------------------------------------------
 //                             Global Variables
 // ---------------------------------------------------------------------------
 
+// With --stats, every heap allocation is counted by operator new (see the
+// Functions section).  Stats::enable() turns counting on before any worker
+// thread starts, and it is never turned off, so the flag needs no atomic.
+bool countingAllocations = false;
+std::atomic<unsigned long long> allocationCount(0);
+std::atomic<unsigned long long> allocationBytes(0);
 
 // ---------------------------------------------------------------------------
 //                             Forward Declarations
 // ---------------------------------------------------------------------------
 
+// One line of a roster dump, with the name still inside the file buffer
+struct DumpRecord
+{
+  const char * name;
+  unsigned int nameLength;
+  int speed;
+};
+
+// One field of a CSV record, as a slice of the file buffer.
+// A quoted field is sliced inside its quotes; if it contains doubled quotes
+// ("") it is marked escaped and must be unescaped before use.
+struct CsvField
+{
+  const char * begin;
+  const char * end;
+  bool escaped;
+};
+
+bool parseSpeed(const char * begin, const char * end, int& speed);
+const char * scanCsvRecord(const char * pos, const char * end, char delimiter,
+                           std::vector<CsvField>& fields);
+bool parseDumpLine(const char * line, const char * lineEnd, DumpRecord& record, bool& blank);
+const char * parseDumpLines(const char * begin, const char * end,
+                            std::vector<DumpRecord>& records);
+
+
+// ---------------------------------------------------------------------------
+//                             Small Roster Templates
+// ---------------------------------------------------------------------------
+
+// Most rosters are small, so for a fixed number of people N the whole
+// solve is spelled out at compile time: a sorting network orders the speeds
+// in a std::array (no heap, no std::sort), then the shielding rounds are
+// unrolled by template recursion.  Everything is constexpr-friendly under
+// C++11, so a constant roster can be solved by the compiler.
+
+// One round of the Shielding Method sends the two slowest people still
+// waiting, top and next, across with the help of the two fastest, f0 and
+// f1.  Every solver takes its rounds from these functions, so they all agree
+// on the times and break ties the same way: a round is Shielding only when
+// that is strictly faster than Naive.
+//   Shielding: f1 and f0 cross, f0 returns, top and next cross, f1 returns
+//   Naive:     top and f0 cross, f0 returns, next and f0 cross, f0 returns
+template <typename T>
+constexpr T shieldingRoundTime(T f0, T f1, T top)
+{
+  return f1 + f0 + top + f1;
+}
+
+template <typename T>
+constexpr T naiveRoundTime(T f0, T top, T next)
+{
+  return top + f0 + next + f0;
+}
+
+template <typename T>
+constexpr bool isShieldingRound(T f0, T f1, T top, T next)
+{
+  return shieldingRoundTime(f0, f1, top) < naiveRoundTime(f0, top, next);
+}
+
+template <typename T>
+constexpr T roundTime(T f0, T f1, T top, T next)
+{
+  return isShieldingRound(f0, f1, top, next) ? shieldingRoundTime(f0, f1, top)
+                                             : naiveRoundTime(f0, top, next);
+}
+
+// roundTime() of int speeds with f0 <= f1 <= next, where only the sum is
+// widened: min(2*f1, f0 + next) is f1 + min(f1, next - (f1 - f0)), and
+// neither side leaves int.  A loop of these over many rosters keeps its
+// min in 32-bit vector lanes, which plain SSE2 has.
+inline long long laneRoundTime(int f0, int f1, int top, int next)
+{
+  return static_cast<long long>(top) + f0 + f1 + std::min(f1, next - (f1 - f0));
+}
+
+// The time of the 0 to 3 fastest people the rounds leave; speeds past the
+// last one left are ignored
+template <typename T>
+constexpr T finalTime(int left, T s0, T s1, T s2)
+{
+  return (left == 3) ? s0 + s1 + s2 : (left == 2) ? s1 : (left == 1) ? s0 : 0;
+}
+
+// The shielding rounds for N people whose speeds are sorted fastest to
+// slowest, unrolled by template recursion
+template <int N>
+struct ShieldingRounds
+{
+  static constexpr long long total(const int * s)
+  {
+    return roundTime<long long>(s[0], s[1], s[N-1], s[N-2]) + ShieldingRounds<N-2>::total(s);
+  }
+};
+
+// The cases where there are 0 to 3 people left
+template <>
+struct ShieldingRounds<0>
+{
+  static constexpr long long total(const int *) { return 0; }
+};
+
+template <>
+struct ShieldingRounds<1>
+{
+  static constexpr long long total(const int * s) { return finalTime<long long>(1, s[0], 0, 0); }
+};
+
+template <>
+struct ShieldingRounds<2>
+{
+  static constexpr long long total(const int * s) { return finalTime<long long>(2, s[0], s[1], 0); }
+};
+
+template <>
+struct ShieldingRounds<3>
+{
+  static constexpr long long total(const int * s) { return finalTime<long long>(3, s[0], s[1], s[2]); }
+};
+
+// The sample problem (people-4.yaml) is checked by the compiler
+constexpr int sampleSpeeds[] = {1, 2, 5, 10};
+static_assert(ShieldingRounds<4>::total(sampleSpeeds) == 17,
+              "shielding rounds must solve the sample problem in 17 minutes");
+
+
+// Odd-even transposition sorting network.  Pass P compares the neighbours
+// (I, I+1) for every I with the parity of P; N passes sort any input.
+// The recursion is over compile-time indexes, so it unrolls completely and
+// the compare-exchanges compile to branchless min/max.
+template <std::size_t N, std::size_t I, bool Done = (I + 1 >= N)>
+struct TranspositionPass
+{
+  static void apply(std::array<int, N>& a)
+  {
+    int lo = std::min(a[I], a[I+1]);
+    int hi = std::max(a[I], a[I+1]);
+    a[I] = lo;
+    a[I+1] = hi;
+    TranspositionPass<N, I + 2>::apply(a);
+  }
+};
+
+template <std::size_t N, std::size_t I>
+struct TranspositionPass<N, I, true>
+{
+  static void apply(std::array<int, N>&) {}
+};
+
+template <std::size_t N, std::size_t P = 0, bool Done = (P >= N)>
+struct SortingNetwork
+{
+  static void sort(std::array<int, N>& a)
+  {
+    TranspositionPass<N, P % 2>::apply(a);
+    SortingNetwork<N, P + 1>::sort(a);
+  }
+};
+
+template <std::size_t N, std::size_t P>
+struct SortingNetwork<N, P, true>
+{
+  static void sort(std::array<int, N>&) {}
+};
+
+// Solve a roster of exactly N speeds, in any order, without allocating
+template <std::size_t N>
+long long solveSmall(std::array<int, N> speeds)
+{
+  SortingNetwork<N>::sort(speeds);
+  return ShieldingRounds<N>::total(speeds.data());
+}
+
+
+// ---------------------------------------------------------------------------
+//                             Pair Costs
+// ---------------------------------------------------------------------------
+
+// The time two people take to cross together is a functor of their speeds,
+// fastest first, so the solvers that take one can model assisted crossings.
+// One person, crossing alone or returning, always takes their own speed.
+// MaxCost is the puzzle's rule, the slower person's pace; the solvers
+// specialize for it, so the default path is the one they always had.
+struct MaxCost
+{
+  int operator()(int, int slow) const
+  {
+    return slow;
+  }
+};
+
+// The slower person's pace plus a fixed penalty, for crossings where one
+// has to help the other (--pair-penalty)
+struct PenaltyCost
+{
+  explicit PenaltyCost(int p) : penalty(p)
+  {
+  }
+
+  int operator()(int, int slow) const
+  {
+    return slow + penalty;
+  }
+
+  int penalty;  // minutes
+};
+
+// A lookup table of pair times by speed (--pair-table).  Pairs not in the
+// table cross at the slower person's pace.
+class TableCost
+{
+public:
+  TableCost() : times()
+  {
+  }
+
+  // The format of the yaml file is:
+  // pairs:
+  //   - [5, 10, 12]
+  // that is, speeds 5 and 10 cross together in 12 minutes.
+  // Returns false (with a message) if the file can't be opened or has a
+  // bad entry.
+  bool readFile(std::string filename)
+  {
+    // yaml-cpp throws on a missing file, after the main results are out
+    std::ifstream probe(filename.c_str());
+    if (!probe)
+    {
+      std::cout << "Error: cannot open " << filename << std::endl;
+      return false;
+    }
+    YAML::Node tableYAML = YAML::LoadFile(filename);
+    YAML::Node pairs = tableYAML["pairs"];
+    for (int k=0; k<pairs.size(); k++)
+    {
+      int a = (pairs[k].size() == 3) ? pairs[k][0].as<int>() : 0;
+      int b = (pairs[k].size() == 3) ? pairs[k][1].as<int>() : 0;
+      int minutes = (pairs[k].size() == 3) ? pairs[k][2].as<int>() : 0;
+      if (a <= 0 || b <= 0 || minutes <= 0)
+      {
+        std::cout << "Error: " << filename << " pair " << k
+                  << ": expected two speeds and a time, all positive" << std::endl;
+        return false;
+      }
+      set(a, b, minutes);
+    }
+    return true;
+  } // end TableCost::readFile()
+
+  // Speeds a and b, in either order, cross together in minutes
+  void set(int a, int b, int minutes)
+  {
+    times[key(std::min(a, b), std::max(a, b))] = minutes;
+  }
+
+  int operator()(int fast, int slow) const
+  {
+    std::unordered_map<long long, int>::const_iterator it = times.find(key(fast, slow));
+    return (it == times.end()) ? slow : it->second;
+  }
+
+private:
+  static long long key(int fast, int slow)
+  {
+    return (static_cast<long long>(fast) << 32) | static_cast<unsigned int>(slow);
+  }
+
+  std::unordered_map<long long, int> times;
+};  // end class TableCost
+
 
 // ---------------------------------------------------------------------------
 //                             Classes
@@ -139,18 +572,69 @@ class Arguments
     bool abort;
     std::string progName;
     std::string peopleFilename;
+    std::string batchFilename;
+    std::string dumpFilename;
+    std::string csvFilename;
+    std::string scheduleFilename;
+    std::string decodeFilename;
+    std::string format;
+    int threads;
+    bool online;
+    bool showSchedule;
+    bool stats;
+    bool perfCounters;
+    bool listPeople;
+    int bridges;
+    int torches;
+    long long torchLimit;
+    std::string exact;
+    std::size_t ttSize;
+    int topK;
+    bool countOptimal;
+    long long maxLoad;
+    int pairPenalty;
+    std::string pairTable;
 
   private:
     std::istringstream optargStream;
 
   public:
-    Arguments() : help(false), abort(false), progName(""), peopleFilename("")
+    Arguments() : help(false), abort(false), progName(""), peopleFilename(""),
+                  batchFilename(""), dumpFilename(""), csvFilename(""),
+                  scheduleFilename(""), decodeFilename(""),
+                  format("text"), threads(0), online(false), showSchedule(false),
+                  stats(false), perfCounters(false), listPeople(false),
+                  bridges(1), torches(1), torchLimit(-1), exact(""),
+                  ttSize(64), topK(0), countOptimal(false), maxLoad(-1),
+                  pairPenalty(-1), pairTable("")
     {
     }
 
   void printHelp()
   {
     std::cout << "Usage: " << progName << " --people <filename> [--help]" << std::endl;
+    std::cout << "       " << progName << " --people - < people.txt" << std::endl;
+    std::cout << "Options: --list-people  print the people as they were read" << std::endl;
+    std::cout << "         --online  report the optimal total after each arrival, and nothing else" << std::endl;
+    std::cout << "         --bridges <n>  also split the people across n bridges" << std::endl;
+    std::cout << "         --torches <n>  also plan the crossings with n torches" << std::endl;
+    std::cout << "         --torch-limit <minutes>  report whether everyone can cross in time" << std::endl;
+    std::cout << "         --exact dfs|parallel|ida  check the optimal total by exhaustive search" << std::endl;
+    std::cout << "         --tt-size <MiB>  transposition table for --exact ida (default 64)" << std::endl;
+    std::cout << "         --top-k <k>  also write the k fastest schedules" << std::endl;
+    std::cout << "         --count-optimal  count the distinct optimal schedules" << std::endl;
+    std::cout << "         --max-load <weight>  also plan for a bridge rated by load, not headcount" << std::endl;
+    std::cout << "         --pair-penalty <minutes>  also plan with pairs taking this much longer" << std::endl;
+    std::cout << "         --pair-table <filename>  also plan with pair times from a table" << std::endl;
+    std::cout << "         --schedule-out <filename>  also write the optimal schedule in binary" << std::endl;
+    std::cout << "         --format text|json|ndjson  output format (default text)" << std::endl;
+    std::cout << "         --schedule  include the optimal schedule in json/ndjson output" << std::endl;
+    std::cout << "         --stats  report time, allocations and bytes for each phase" << std::endl;
+    std::cout << "         --perf-counters  add hardware counters to the --stats report" << std::endl;
+    std::cout << "       " << progName << " --people-dump <filename> [--threads <n>]" << std::endl;
+    std::cout << "       " << progName << " --people-csv <filename>" << std::endl;
+    std::cout << "       " << progName << " --batch <filename>" << std::endl;
+    std::cout << "       " << progName << " --decode-schedule <filename>" << std::endl;
   } // end Arguments::printHelp()
 
   // -----------------------------------------------------------------------
@@ -165,6 +649,28 @@ class Arguments
       //{"brief",   no_argument,       &verbose_flag, 0},
 
       {"people",       required_argument, nullptr, 'p'},
+      {"people-dump",  required_argument, nullptr, 'd'},
+      {"people-csv",   required_argument, nullptr, 'c'},
+      {"threads",      required_argument, nullptr, 't'},
+      {"online",       no_argument,       nullptr, 'o'},
+      {"list-people",  no_argument,       nullptr, 'l'},
+      {"bridges",      required_argument, nullptr, 'B'},
+      {"torches",      required_argument, nullptr, 'R'},
+      {"torch-limit",  required_argument, nullptr, 'L'},
+      {"exact",        required_argument, nullptr, 'E'},
+      {"tt-size",      required_argument, nullptr, 'Z'},
+      {"top-k",        required_argument, nullptr, 'K'},
+      {"count-optimal", no_argument,      nullptr, 'C'},
+      {"max-load",     required_argument, nullptr, 'W'},
+      {"pair-penalty", required_argument, nullptr, 'Y'},
+      {"pair-table",   required_argument, nullptr, 'y'},
+      {"schedule-out", required_argument, nullptr, 's'},
+      {"decode-schedule", required_argument, nullptr, 'x'},
+      {"format",       required_argument, nullptr, 'f'},
+      {"schedule",     no_argument,       nullptr, 'S'},
+      {"stats",        no_argument,       nullptr, 'T'},
+      {"perf-counters", no_argument,      nullptr, 'P'},
+      {"batch",        required_argument, nullptr, 'b'},
       {"help",         no_argument,       nullptr, 'h'},
       {nullptr,        0,                 nullptr, 0  }
     };
@@ -214,6 +720,178 @@ class Arguments
           optargStream >> peopleFilename;
           break;
 
+        case 'd':
+          if (DEBUG==1) { std::cout << "option --people-dump with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> dumpFilename;
+          break;
+
+        case 'c':
+          if (DEBUG==1) { std::cout << "option --people-csv with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> csvFilename;
+          break;
+
+        case 't':
+          if (DEBUG==1) { std::cout << "option --threads with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> threads;
+          break;
+
+        case 'b':
+          if (DEBUG==1) { std::cout << "option --batch with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> batchFilename;
+          break;
+
+        case 's':
+          if (DEBUG==1) { std::cout << "option --schedule-out with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> scheduleFilename;
+          break;
+
+        case 'x':
+          if (DEBUG==1) { std::cout << "option --decode-schedule with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> decodeFilename;
+          break;
+
+        case 'f':
+          if (DEBUG==1) { std::cout << "option --format with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> format;
+          if (format != "text" && format != "json" && format != "ndjson")
+          {
+            std::cout << "Error: unknown format " << format << ", expected text, json or ndjson" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'S':
+          if (DEBUG==1) { std::cout << "option --schedule" << std::endl; }
+          showSchedule = true;
+          break;
+
+        case 'T':
+          if (DEBUG==1) { std::cout << "option --stats" << std::endl; }
+          stats = true;
+          break;
+
+        case 'P':
+          if (DEBUG==1) { std::cout << "option --perf-counters" << std::endl; }
+          stats = true;
+          perfCounters = true;
+          break;
+
+        case 'o':
+          if (DEBUG==1) { std::cout << "option --online" << std::endl; }
+          online = true;
+          break;
+
+        case 'B':
+          if (DEBUG==1) { std::cout << "option --bridges with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> bridges;
+          if (bridges < 1)
+          {
+            std::cout << "Error: --bridges needs at least 1 bridge" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'R':
+          if (DEBUG==1) { std::cout << "option --torches with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> torches;
+          if (torches < 1)
+          {
+            std::cout << "Error: --torches needs at least 1 torch" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'L':
+          if (DEBUG==1) { std::cout << "option --torch-limit with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> torchLimit;
+          if (optargStream.fail() || torchLimit < 0)
+          {
+            std::cout << "Error: --torch-limit needs a number of minutes" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'E':
+          if (DEBUG==1) { std::cout << "option --exact with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> exact;
+          if (exact != "dfs" && exact != "parallel" && exact != "ida")
+          {
+            std::cout << "Error: unknown exact search " << exact << ", expected dfs, parallel or ida" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'Z':
+          if (DEBUG==1) { std::cout << "option --tt-size with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> ttSize;
+          if (optargStream.fail() || ttSize < 1)
+          {
+            std::cout << "Error: --tt-size needs a number of MiB" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'K':
+          if (DEBUG==1) { std::cout << "option --top-k with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> topK;
+          if (optargStream.fail() || topK < 1)
+          {
+            std::cout << "Error: --top-k needs at least 1 schedule" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'C':
+          if (DEBUG==1) { std::cout << "option --count-optimal" << std::endl; }
+          countOptimal = true;
+          break;
+
+        case 'W':
+          if (DEBUG==1) { std::cout << "option --max-load with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> maxLoad;
+          if (optargStream.fail() || maxLoad < 0)
+          {
+            std::cout << "Error: --max-load needs a weight" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'Y':
+          if (DEBUG==1) { std::cout << "option --pair-penalty with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> pairPenalty;
+          if (optargStream.fail() || pairPenalty < 0)
+          {
+            std::cout << "Error: --pair-penalty needs a number of minutes" << std::endl;
+            abort = true;
+          }
+          break;
+
+        case 'y':
+          if (DEBUG==1) { std::cout << "option --pair-table with value " << optarg << std::endl; }
+          optargStream.str(optarg);
+          optargStream >> pairTable;
+          break;
+
+        case 'l':
+          if (DEBUG==1) { std::cout << "option --list-people" << std::endl; }
+          listPeople = true;
+          break;
+
         case 'h':
           if (DEBUG==1) { std::cout << "option --help" << std::endl; }
           help = true;
@@ -238,6 +916,72 @@ class Arguments
 
     } // end while
 
+    if (pairPenalty >= 0 && pairTable != "")
+    {
+      std::cout << "Error: --pair-penalty and --pair-table are two costs, give one" << std::endl;
+      abort = true;
+    }
+
+    // Online mode only writes the running total after each arrival, as
+    // text, so any other output asked for would be dropped
+    if (online)
+    {
+      std::string other;
+      if (format != "text")
+      {
+        other = "--format " + format;
+      }
+      else if (listPeople)
+      {
+        other = "--list-people";
+      }
+      else if (bridges > 1)
+      {
+        other = "--bridges";
+      }
+      else if (torches > 1)
+      {
+        other = "--torches";
+      }
+      else if (torchLimit >= 0)
+      {
+        other = "--torch-limit";
+      }
+      else if (exact != "")
+      {
+        other = "--exact";
+      }
+      else if (topK > 0)
+      {
+        other = "--top-k";
+      }
+      else if (countOptimal)
+      {
+        other = "--count-optimal";
+      }
+      else if (maxLoad >= 0)
+      {
+        other = "--max-load";
+      }
+      else if (pairPenalty >= 0 || pairTable != "")
+      {
+        other = (pairPenalty >= 0) ? "--pair-penalty" : "--pair-table";
+      }
+      else if (scheduleFilename != "" || showSchedule)
+      {
+        other = showSchedule ? "--schedule" : "--schedule-out";
+      }
+      else if (stats || perfCounters)
+      {
+        other = stats ? "--stats" : "--perf-counters";
+      }
+      if (other != "")
+      {
+        std::cout << "Error: --online only reports the running total, not " << other << std::endl;
+        abort = true;
+      }
+    }
+
     // Process any remaining command line arguments (not options)
     if (optind < argc)
     {
@@ -257,345 +1001,6890 @@ class Arguments
 }; // end class Arguments
 
 
-// This class represents the info about a person.
-// The name and speed members are private, and have get and set functions.
-// There is a member function to print a Person.
-class Person
+// A reference to a name stored in the NamePool: a pointer and a length,
+// which is what std::string_view would be if this were C++17.
+struct NameRef
+{
+  const char * data;
+  unsigned int length;
+};
+
+
+// This class stores every person's name exactly once.
+// The characters are copied into large blocks (a bump arena) that are never
+// moved or freed while the program runs, so a NameRef stays valid forever.
+// Duplicated names are interned: asking for a name that is already stored
+// returns the existing copy.  The index of stored names is an open-addressing
+// hash table, so interning a name costs no allocation of its own.
+class NamePool
 {
 public:
-  Person() : name(""), speed(0)
+  NamePool() : slots(), count(0), blocks(), blockUsed(NAME_BLOCK_SIZE)
   {
   }
 
-  Person(std::string n, int s) : name(n), speed(s)
+  // All Person objects share one pool
+  static NamePool& global()
   {
+    static NamePool pool;
+    return pool;
   }
 
-  // This operator is for sorting
-  bool operator<(const Person& other) const
+  NameRef intern(const char * data, std::size_t length)
   {
-    return (speed < other.speed);
-  }
+    // Keep the table at most 3/4 full
+    if ((count + 1) * 4 > slots.size() * 3)
+    {
+      grow();
+    }
 
-  void print(std::ostream& os)
-  {
-    // Print a Person in this format:  (Fred,12)
-    os << "(" << name << "," << speed << ")";
-  }
+    std::size_t mask = slots.size() - 1;
+    std::size_t i = hash(data, length) & mask;
+    while (slots[i].data != nullptr)
+    {
+      if (slots[i].length == length && std::memcmp(slots[i].data, data, length) == 0)
+      {
+        return slots[i];
+      }
+      i = (i + 1) & mask;
+    }
 
-  void setName(std::string n)
-  {
-    name = n;
-  }
+    NameRef ref;
+    ref.data = store(data, length);
+    ref.length = length;
+    slots[i] = ref;
+    count++;
+    return ref;
+  } // end NamePool::intern()
 
-  void setSpeed(int s)
+  // The number of distinct names stored
+  std::size_t size() const
   {
-    speed = s;
+    return count;
   }
 
-  std::string getName()
+private:
+  // Copy the characters into the current block, starting a new block when
+  // it is full.  Very long names get a block of their own.
+  const char * store(const char * data, std::size_t length)
   {
-    return name;
-  }
-
-  int getSpeed()
+    if (length > NAME_BLOCK_SIZE / 4)
+    {
+      blocks.emplace_back(new char[length + 1]);
+      std::memcpy(blocks.back().get(), data, length);
+      return blocks.back().get();
+    }
+    if (blockUsed + length > NAME_BLOCK_SIZE)
+    {
+      blocks.emplace_back(new char[NAME_BLOCK_SIZE]);
+      blockUsed = 0;
+    }
+    char * copy = blocks.back().get() + blockUsed;
+    std::memcpy(copy, data, length);
+    blockUsed += length;
+    return copy;
+  } // end NamePool::store()
+
+  // Double the hash table and re-insert every stored name
+  void grow()
   {
-    return speed;
+    std::vector<NameRef> old;
+    old.swap(slots);
+
+    NameRef empty;
+    empty.data = nullptr;
+    empty.length = 0;
+    slots.assign(old.empty() ? 1024 : old.size() * 2, empty);
+
+    std::size_t mask = slots.size() - 1;
+    for (int j=0; j<old.size(); j++)
+    {
+      if (old[j].data != nullptr)
+      {
+        std::size_t i = hash(old[j].data, old[j].length) & mask;
+        while (slots[i].data != nullptr)
+        {
+          i = (i + 1) & mask;
+        }
+        slots[i] = old[j];
+      }
+    }
+  } // end NamePool::grow()
+
+  // FNV-1a
+  static std::size_t hash(const char * data, std::size_t length)
+  {
+    std::size_t h = 2166136261u;
+    for (std::size_t i=0; i<length; i++)
+    {
+      h = (h ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+    return h;
   }
 
-private:
-  std::string name;
-  int speed; // the time to cross the bridge, in minutes
-};  // end class Person
+  std::vector<NameRef> slots;
+  std::size_t count;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  std::size_t blockUsed; // bytes used in the last block
+};  // end class NamePool
 
-// helper function to print Person within a stream
-std::ostream& operator<<(std::ostream& os, Person& p)
+
+// This class reads the CPU's hardware performance counters (cycles,
+// instructions, cache misses, branch misses) for this process, through
+// Linux perf_event_open().  Each counter is opened on its own, counting
+// user space only, so one the machine lacks (common in VMs) or a
+// restrictive perf_event_paranoid setting just leaves that counter
+// unavailable.  On other systems no counter is ever available.
+class PerfCounters
 {
-  p.print(os);
-  return os;
-};
+public:
+  PerfCounters()
+  {
+    for (int i=0; i<PERF_COUNTERS; i++)
+    {
+      fds[i] = -1;
+    }
+  }
+
+  ~PerfCounters()
+  {
+    for (int i=0; i<PERF_COUNTERS; i++)
+    {
+      if (fds[i] >= 0)
+      {
+        close(fds[i]);
+      }
+    }
+  }
 
+  // Open and start the counters.  Returns true if any of them opened.
+  bool open()
+  {
+    bool any = false;
+#if defined(__linux__)
+    const unsigned long long configs[PERF_COUNTERS] =
+      {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+       PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i=0; i<PERF_COUNTERS; i++)
+    {
+      struct perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.inherit = 1; // include the parsing threads
+      fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      any = any || (fds[i] >= 0);
+    }
+#endif
+    return any;
+  } // end PerfCounters::open()
 
-// The Bridge class contains member functions to:
-// - read the yaml file into a private vector of people
-// - the Naive method to compute the shortest crossing time
-// - the Shielding method to compute the shortest crossing time
-// There is a private vector of waiting people.
-class Bridge
+  bool available(int i) const
+  {
+    return fds[i] >= 0;
+  }
+
+  // Read the current counts; an unavailable counter reads as 0
+  void read(unsigned long long values[PERF_COUNTERS]) const
+  {
+    for (int i=0; i<PERF_COUNTERS; i++)
+    {
+      values[i] = 0;
+      if (fds[i] >= 0 && ::read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i]))
+      {
+        values[i] = 0;
+      }
+    }
+  }
+
+private:
+  PerfCounters(const PerfCounters&);
+  PerfCounters& operator=(const PerfCounters&);
+
+  int fds[PERF_COUNTERS];
+};  // end class PerfCounters
+
+
+// This class collects the --stats instrumentation: wall time and heap
+// allocations per phase of the run (load, list, sort, naive, optimal,
+// output), bytes read and written, and the number of people.  With
+// --perf-counters each phase also gets the hardware counter deltas.
+// Phases are timed by PhaseTimer objects; when stats are off they do
+// nothing, so the instrumentation costs a flag test.
+class Stats
 {
 public:
-  Bridge() : waitingPeople()
+  // The totals for one phase; a phase may be entered more than once
+  struct Phase
+  {
+    const char * name;
+    long long nanoseconds;
+    unsigned long long allocations;
+    unsigned long long allocatedBytes;
+    unsigned long long counters[PERF_COUNTERS];
+  };
+
+  Stats() : on(false), perfRequested(false), perfOn(false), perf(), phases(), read(0), written(0), people(0),
+            start(std::chrono::steady_clock::now())
   {
   }
 
-  // Parse the yaml, put the resulting people into the waiting people vector
-  // Isolate the file operations and yaml parsing in one function
-  void readPeopleFile(std::string filename)
+  // All phases report to one set of stats
+  static Stats& global()
   {
-    // The format of the yaml file is:
-    // people:
-    //   - name: A
-    //     speed: 1
-    //   - name: B
-    //     speed: 2
+    static Stats stats;
+    return stats;
+  }
 
-    // Use the yaml-cpp C++ parser to parse the yaml file into a Node.
-    YAML::Node peopleYAML = YAML::LoadFile(filename);
+  void enable()
+  {
+    on = true;
+    countingAllocations = true;
+    start = std::chrono::steady_clock::now();
+  }
+
+  bool enabled() const
+  {
+    return on;
+  }
 
-    if (DEBUG==1) {std::cout << "people:" << std::endl << peopleYAML["people"] << std::endl;}
+  // Also read the hardware counters around each phase.  Returns false if
+  // none are available; the report then says so instead of showing them.
+  bool enablePerfCounters()
+  {
+    perfOn = perf.open();
+    return perfOn;
+  }
 
-    std::cout << std::endl;
-    if (peopleYAML["people"].size() > 0)
+  bool perfCountersEnabled() const
+  {
+    return perfOn;
+  }
+
+  const PerfCounters& perfCounters() const
+  {
+    return perf;
+  }
+
+  // counters holds the hardware counter deltas, or is nullptr
+  void addPhase(const char * name, long long nanoseconds,
+                unsigned long long allocations, unsigned long long allocatedBytes,
+                const unsigned long long * counters)
+  {
+    Phase * phase = nullptr;
+    for (int i=0; i<phases.size(); i++)
     {
-      std::cout << "List of all people:" << std::endl;
+      if (std::strcmp(phases[i].name, name) == 0)
+      {
+        phase = &phases[i];
+      }
     }
-    else
+    if (phase == nullptr)
     {
-      std::cout << "No people found in YAML input file" << std::endl;
+      Phase empty;
+      std::memset(&empty, 0, sizeof(empty));
+      empty.name = name;
+      phases.push_back(empty);
+      phase = &phases.back();
     }
-    for (int i=0; i<peopleYAML["people"].size(); i++)
-    {
-      std::cout << "Person " << i << " -  Name: " << peopleYAML["people"][i]["name"] << "  Speed: " << peopleYAML["people"][i]["speed"] << std::endl;
 
-      // Add each person to the vector
-      Person p;
-      p.setName( peopleYAML["people"][i]["name"].as<std::string>() );
-      p.setSpeed( peopleYAML["people"][i]["speed"].as<int>() );
-      waitingPeople.emplace_back(p);
+    phase->nanoseconds += nanoseconds;
+    phase->allocations += allocations;
+    phase->allocatedBytes += allocatedBytes;
+    for (int c=0; c<PERF_COUNTERS && counters != nullptr; c++)
+    {
+      phase->counters[c] += counters[c];
     }
+  } // end Stats::addPhase()
 
-  } // end Bridge::readPeopleFile()
+  void addBytesRead(unsigned long long bytes)
+  {
+    read += bytes;
+  }
 
+  void addBytesWritten(unsigned long long bytes)
+  {
+    written += bytes;
+  }
 
-  // Given a vector of people, compute the optimal minimum speed
-  // for them all to cross the bridge.
-  // This implements the Shielding Method.
-  int crossOptimally()
+  void setPeople(long long n)
   {
-    int totalSpeed = 0;
+    people = n;
+  }
 
-    // Sort the people, fastest to slowest
-    std::sort( waitingPeople.begin(), waitingPeople.end() );
+  const std::vector<Phase>& allPhases() const
+  {
+    return phases;
+  }
 
-    std::cout << std::endl;
-    std::cout << "Optimal sequence of bridge crossings:" << std::endl;
+  unsigned long long bytesRead() const
+  {
+    return read;
+  }
 
-    // Keep sending the two slowest people over the bridge,
-    // as long as there are at least 4 total people left.
-    while (waitingPeople.size() >= 4)
-    {
-      int totalShielding, totalNaive;
-      int n = waitingPeople.size();
+  unsigned long long bytesWritten() const
+  {
+    return written;
+  }
 
-      // See how long it would take using each method
+  long long peopleCount() const
+  {
+    return people;
+  }
 
-      // The Shielding Method: the two slowest people go together
-      totalShielding = waitingPeople[1].getSpeed() +   // send the two fastest
-                       waitingPeople[0].getSpeed() +   // the fastest returns
-                       waitingPeople[n-1].getSpeed() + // send the two slowest
-                       waitingPeople[1].getSpeed();    // second fastest returns
+  // Wall time since stats were enabled
+  long long elapsedNanoseconds() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start).count();
+  }
 
-      // The Naive Method: always pair with the fastest person
-      totalNaive = waitingPeople[n-1].getSpeed() + // slowest with fastest
-                   waitingPeople[0].getSpeed() +   // the fastest returns
-                   waitingPeople[n-2].getSpeed() + // next slowest with fastest
-                   waitingPeople[0].getSpeed();    // the fastest returns
+  // People handled per second of wall time
+  double peoplePerSecond() const
+  {
+    long long ns = elapsedNanoseconds();
+    return (ns > 0) ? people * 1e9 / ns : 0.0;
+  }
 
-      if (totalShielding < totalNaive)
-      {
-        // Use the Shielding Method
-        std::cout << waitingPeople[1] << " and " << waitingPeople[0] << " cross" << std::endl;
-        std::cout << waitingPeople[0] << " returns" << std::endl;
-        std::cout << waitingPeople[n-1] << " and " << waitingPeople[n-2] << " cross" << std::endl;
-        std::cout << waitingPeople[1] << " returns" << std::endl;
-        totalSpeed += totalShielding;
-      }
-      else
-      {
-        // Use the Naive Method
-        std::cout << waitingPeople[n-1] << " and " << waitingPeople[0] << " cross" << std::endl;
-        std::cout << waitingPeople[0] << " returns" << std::endl;
-        std::cout << waitingPeople[n-2] << " and " << waitingPeople[0] << " cross" << std::endl;
-        std::cout << waitingPeople[0] << " returns" << std::endl;
-        totalSpeed += totalNaive;
-      }
-      // the two slowest people are now across, so remove them from the vector
-      waitingPeople.pop_back();
-      waitingPeople.pop_back();
+  // Print the report as a table
+  void print(std::ostream& os) const
+  {
+    os << std::endl;
+    os << "Statistics:" << std::endl;
+    os << "  Phase        Time (ms)  Allocations     Bytes" << std::endl;
+    for (int i=0; i<phases.size(); i++)
+    {
+      os << "  " << std::left << std::setw(10) << phases[i].name << std::right
+         << std::setw(11) << std::fixed << std::setprecision(3) << phases[i].nanoseconds / 1e6
+         << std::setw(13) << phases[i].allocations
+         << std::setw(10) << phases[i].allocatedBytes << std::endl;
     }
+    os << "  Total time (ms): " << elapsedNanoseconds() / 1e6 << std::endl;
+    os << "  Allocations: " << allocationCount.load() << " (" << allocationBytes.load() << " bytes)" << std::endl;
+    os << "  Bytes read: " << read << std::endl;
+    os << "  Bytes written: " << written << std::endl;
+    os << "  People: " << people << " (" << std::setprecision(0) << peoplePerSecond() << " people/sec)" << std::endl;
+    os.unsetf(std::ios_base::floatfield);
+    os << std::setprecision(6);
 
-    // Handle the cases where there are 0 to 3 people left
-    if (waitingPeople.size() == 0)
+    if (perfRequested)
     {
-      totalSpeed += 0;
+      printPerfCounters(os);
     }
-    else if (waitingPeople.size() == 1)
+  } // end Stats::print()
+
+  // Print the hardware counters of each phase, or why there are none
+  void printPerfCounters(std::ostream& os) const
+  {
+    os << std::endl;
+    if (!perfOn)
     {
-      std::cout << waitingPeople[0] << " crosses" << std::endl;
-      totalSpeed += waitingPeople[0].getSpeed();
-      waitingPeople.pop_back();
+      os << "Hardware counters: not available on this system" << std::endl;
+      return;
     }
-    else if (waitingPeople.size() == 2)
+
+    os << "Hardware counters:" << std::endl;
+    os << "  Phase     ";
+    for (int c=0; c<PERF_COUNTERS; c++)
     {
-      std::cout << waitingPeople[1] << " and " << waitingPeople[0] << " cross" << std::endl;
-      totalSpeed += waitingPeople[1].getSpeed();
-      waitingPeople.pop_back();
-      waitingPeople.pop_back();
+      os << std::setw(16) << PERF_COUNTER_NAMES[c];
     }
-    else if (waitingPeople.size() == 3)
+    os << std::endl;
+    for (int i=0; i<phases.size(); i++)
     {
-      std::cout << waitingPeople[2] << " and " << waitingPeople[0] << " cross" << std::endl;
-      std::cout << waitingPeople[0] << " returns" << std::endl;
-      std::cout << waitingPeople[1] << " and " << waitingPeople[0] << " cross" << std::endl;
-      totalSpeed += waitingPeople[0].getSpeed() + waitingPeople[1].getSpeed() + waitingPeople[2].getSpeed();
-      waitingPeople.pop_back();
-      waitingPeople.pop_back();
-      waitingPeople.pop_back();
+      os << "  " << std::left << std::setw(10) << phases[i].name << std::right;
+      for (int c=0; c<PERF_COUNTERS; c++)
+      {
+        if (perf.available(c))
+        {
+          os << std::setw(16) << phases[i].counters[c];
+        }
+        else
+        {
+          os << std::setw(16) << "n/a";
+        }
+      }
+      os << std::endl;
     }
+  } // end Stats::printPerfCounters()
 
-    return totalSpeed;
-  } // end Bridge::crossOptimally()
-
+  // Whether --perf-counters was given, even if no counter could be opened
+  void requestPerfCounters()
+  {
+    perfRequested = true;
+    enablePerfCounters();
+  }
 
-  // Given a vector of people, compute the minimum speed
-  // for them all to cross the bridge.
-  // This implements the (incorrect) Naive Method.
-  int crossNaively()
+  bool perfCountersRequested() const
   {
-    int totalSpeed = 0;
+    return perfRequested;
+  }
+
+private:
+  bool on;
+  bool perfRequested;
+  bool perfOn;
+  PerfCounters perf;
+  std::vector<Phase> phases;
+  unsigned long long read;
+  unsigned long long written;
+  long long people;
+  std::chrono::steady_clock::time_point start;
+};  // end class Stats
 
-    // The Naive Method is to pair each person with the overall fastest person,
-    // then send that fastest person back with the torch to get another
-    // person.  This sometimes yields the fastest overall time, but not always.
 
-    // If there are no people:
-    if (waitingPeople.size() == 0)
+// This class times the phase it is named after, from construction to
+// destruction, and reports the time and allocations to Stats::global().
+//   {
+//     PhaseTimer timer("sort");
+//     std::sort(...);
+//   }
+class PhaseTimer
+{
+public:
+  PhaseTimer(const char * phaseName) : name(phaseName), on(Stats::global().enabled())
+  {
+    if (on)
     {
-      return 0;
+      allocations = allocationCount.load(std::memory_order_relaxed);
+      allocatedBytes = allocationBytes.load(std::memory_order_relaxed);
+      if (Stats::global().perfCountersEnabled())
+      {
+        Stats::global().perfCounters().read(counters);
+      }
+      start = std::chrono::steady_clock::now();
     }
+  }
 
-    // If there is only one person:
-    if (waitingPeople.size() == 1)
+  ~PhaseTimer()
+  {
+    if (on)
     {
-      return waitingPeople[0].getSpeed();
+      long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start).count();
+      const unsigned long long * deltas = nullptr;
+      if (Stats::global().perfCountersEnabled())
+      {
+        unsigned long long now[PERF_COUNTERS];
+        Stats::global().perfCounters().read(now);
+        for (int c=0; c<PERF_COUNTERS; c++)
+        {
+          counters[c] = now[c] - counters[c];
+        }
+        deltas = counters;
+      }
+      Stats::global().addPhase(name, ns,
+                               allocationCount.load(std::memory_order_relaxed) - allocations,
+                               allocationBytes.load(std::memory_order_relaxed) - allocatedBytes,
+                               deltas);
     }
+  }
 
-    // Find the fastest overall person
-    // If two or more people have the fastest speed, only one will be picked
-    // (Could have made this a member function, but decided to leave it here)
-    Person fastest;
-    int fastestindex = -1;
+private:
+  PhaseTimer(const PhaseTimer&);
+  PhaseTimer& operator=(const PhaseTimer&);
 
-    fastest.setName("maxint");
-    fastest.setSpeed( std::numeric_limits<int>::max() );
-    for (int i=0; i<waitingPeople.size(); i++)
+  const char * name;
+  bool on;
+  unsigned long long allocations;
+  unsigned long long allocatedBytes;
+  unsigned long long counters[PERF_COUNTERS];
+  std::chrono::steady_clock::time_point start;
+};  // end class PhaseTimer
+
+
+// This stream buffer puts itself in front of a stream's buffer, passes
+// everything through and counts the bytes, so --stats can report what was
+// written to std::cout.  The stream gets its buffer back on destruction.
+class CountingStreambuf : public std::streambuf
+{
+public:
+  CountingStreambuf(std::ostream& os) : stream(os), next(os.rdbuf())
+  {
+    stream.rdbuf(this);
+  }
+
+  ~CountingStreambuf()
+  {
+    stream.rdbuf(next);
+  }
+
+protected:
+  virtual int overflow(int c)
+  {
+    if (c != traits_type::eof())
     {
-      if ( waitingPeople[i].getSpeed() < fastest.getSpeed() )
-      {
-        fastest.setName( waitingPeople[i].getName() );
-        fastest.setSpeed( waitingPeople[i].getSpeed() );
-        fastestindex = i;
-      }
+      Stats::global().addBytesWritten(1);
+      return next->sputc(c);
     }
+    return traits_type::not_eof(c);
+  }
 
-    std::cout << std::endl;
-    std::cout << "Fastest overall person: " << fastest << std::endl;
+  virtual std::streamsize xsputn(const char * s, std::streamsize n)
+  {
+    Stats::global().addBytesWritten(n);
+    return next->sputn(s, n);
+  }
 
-    // Note: I could have saved time (namely one fewer pass through all the
-    // people) by just processing vector and skipping the fastest person,
-    // but I'm using a queue to make the last loop a bit more understandable.
+  virtual int sync()
+  {
+    return next->pubsync();
+  }
 
-    // Put every person into a queue, except the fastest
-    std::queue<Person> q;
-    for (int i=0; i<waitingPeople.size(); i++)
+private:
+  std::ostream& stream;
+  std::streambuf * next;
+};  // end class CountingStreambuf
+
+
+// This class maps a whole file read-only into memory, so parsers can work
+// on the bytes in place instead of copying them through a stream.
+// The mapping is released when the object goes away.
+class MappedFile
+{
+public:
+  MappedFile() : bytes(nullptr), length(0)
+  {
+  }
+
+  ~MappedFile()
+  {
+    if (bytes != nullptr)
     {
-      if (i != fastestindex)
-      {
-        Person p;
-        p.setName( waitingPeople[i].getName() );
-        p.setSpeed( waitingPeople[i].getSpeed() );
-        q.emplace(p);
-      }
+      munmap(const_cast<char *>(bytes), length);
     }
+  }
 
-    // Process the queue
-    std::cout << std::endl;
-    std::cout << "Naive sequence of bridge crossings:" << std::endl;
-    while (q.size() > 0)
+  // Returns false (with a message) if the file can't be opened or mapped
+  bool open(std::string filename)
+  {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      std::cout << "Error: cannot open " << filename << std::endl;
+      return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
     {
-      // Compute the crossing time of the next pair.
-      // Note that the slower of the pair is always the person on the queue,
-      // because each person on the queue is paired with the fastest overall
-      // person.
-      totalSpeed += q.front().getSpeed(); // add the slower speed of the pair
-      std::cout << q.front() << " and " << fastest << " cross" << std::endl;
-      q.pop();
+      std::cout << "Error: cannot read the size of " << filename << std::endl;
+      close(fd);
+      return false;
+    }
+    length = info.st_size;
+    Stats::global().addBytesRead(length);
 
-      // If anyone is left in the queue,
-      // send the fastest person back over the bridge.
-      if (q.size() > 0)
+    // An empty file has nothing to map
+    if (length > 0)
+    {
+      void * mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped == MAP_FAILED)
       {
-        std::cout << fastest << " returns" << std::endl;
-        totalSpeed += fastest.getSpeed(); // the faster person returns
+        std::cout << "Error: cannot map " << filename << std::endl;
+        close(fd);
+        length = 0;
+        return false;
       }
+      bytes = static_cast<const char *>(mapped);
     }
+    close(fd);
+    return true;
+  } // end MappedFile::open()
 
-    return totalSpeed;
-  } // end Bridge::crossNaively()
+  const char * begin() const
+  {
+    return bytes;
+  }
+
+  const char * end() const
+  {
+    return bytes + length;
+  }
+
+  std::size_t size() const
+  {
+    return length;
+  }
 
 private:
-  std::vector<Person> waitingPeople;
+  // Not copyable, the mapping has one owner
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
 
-}; // end class Bridge
+  const char * bytes;
+  std::size_t length;
+};  // end class MappedFile
 
 
-// --------------------------------------------------------------------------
-//                             Functions
-// --------------------------------------------------------------------------
+// This class collects output in a large buffer and hands it to the C
+// library in big blocks, avoiding the per-call cost of iostreams (and the
+// flush of every std::endl) when writing a lot of small pieces.
+// Call flush() before writing to the same file by other means.
+class BufferedWriter
+{
+public:
+  BufferedWriter(std::FILE * f) : file(f), buffer(WRITE_BUFFER_SIZE), used(0), written(0)
+  {
+  }
 
+  ~BufferedWriter()
+  {
+    flush();
+  }
 
-// -------------------------------------------------------------------------
-//                             Main Program
-// -------------------------------------------------------------------------
-int main(int argc, char * argv[]) {
-  int total = 0;
+  void put(char c)
+  {
+    if (used == buffer.size())
+    {
+      flush();
+    }
+    buffer[used++] = c;
+  }
 
-  std::cout << "Running..." << std::endl;
+  void write(const char * data, std::size_t length)
+  {
+    if (used + length > buffer.size())
+    {
+      flush();
+      if (length > buffer.size())
+      {
+        std::fwrite(data, 1, length, file);
+        written += length;
+        Stats::global().addBytesWritten(length);
+        return;
+      }
+    }
+    std::memcpy(buffer.data() + used, data, length);
+    used += length;
+  }
 
-  // Process the command line arguments
+  void write(const std::string& text)
+  {
+    write(text.data(), text.size());
+  }
 
-  Arguments args;
-  args.getArgs(argc, argv);
-  if (args.help)
+  void write(const char * text)
   {
-    args.printHelp();
+    write(text, std::strlen(text));
   }
-  if (args.abort)
+
+  void write(long long value)
   {
-    return 0;
+    char digits[24];
+    int length = std::snprintf(digits, sizeof(digits), "%lld", value);
+    write(digits, length);
   }
-  if (args.peopleFilename == "")
+
+  // Unsigned LEB128: 7 bits per byte, low bits first, high bit set on every
+  // byte but the last.  Small numbers take one byte.
+  void writeVarint(unsigned long long value)
   {
-    std::cout << args.progName << ": ERROR: Missing option peopleFile" << std::endl;
-    return 0;
+    while (value >= 0x80)
+    {
+      put(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    put(static_cast<char>(value));
   }
-  if (DEBUG==1) {std::cout << "peopleFilename=<" << args.peopleFilename << ">" << std::endl;}
 
-  // We have the arguments, now do the real stuff
+  void flush()
+  {
+    if (used > 0)
+    {
+      std::fwrite(buffer.data(), 1, used, file);
+      written += used;
+      Stats::global().addBytesWritten(used);
+      used = 0;
+    }
+    std::fflush(file);
+  }
 
-  Bridge narrowBridge;
+  // Bytes handed to the file so far
+  unsigned long long bytesWritten() const
+  {
+    return written + used;
+  }
 
-  narrowBridge.readPeopleFile(args.peopleFilename);
+private:
+  // Not copyable, the buffer has one owner
+  BufferedWriter(const BufferedWriter&);
+  BufferedWriter& operator=(const BufferedWriter&);
 
-  // For comparison, do both the Naive and Shielding methods
+  std::FILE * file;
+  std::vector<char> buffer;
+  std::size_t used;
+  unsigned long long written;
+};  // end class BufferedWriter
 
-  total = narrowBridge.crossNaively();
-  std::cout << std::endl;
-  std::cout << "The naive fastest total time is: " << total << std::endl;
 
-  total = narrowBridge.crossOptimally();
-  std::cout << std::endl;
-  std::cout << "The optimal fastest total time is: " << total << std::endl;
+// This class writes JSON straight to a BufferedWriter as values arrive,
+// without building a document in memory.  It only tracks whether a comma is
+// needed at each level of nesting.  Keys and string values are escaped.
+class JsonWriter
+{
+public:
+  JsonWriter(BufferedWriter& w) : out(w), first(), afterKey(false)
+  {
+  }
+
+  void beginObject()
+  {
+    separate();
+    out.put('{');
+    first.push_back(true);
+  }
+
+  void endObject()
+  {
+    out.put('}');
+    first.pop_back();
+  }
+
+  void beginArray()
+  {
+    separate();
+    out.put('[');
+    first.push_back(true);
+  }
+
+  void endArray()
+  {
+    out.put(']');
+    first.pop_back();
+  }
+
+  void key(const char * name)
+  {
+    separate();
+    writeString(name, std::strlen(name));
+    out.put(':');
+    afterKey = true;
+  }
+
+  void value(long long number)
+  {
+    separate();
+    out.write(number);
+  }
+
+  void value(const char * data, std::size_t length)
+  {
+    separate();
+    writeString(data, length);
+  }
+
+  void value(const char * text)
+  {
+    value(text, std::strlen(text));
+  }
+
+  void value(bool flag)
+  {
+    separate();
+    out.write(flag ? "true" : "false", flag ? 4 : 5);
+  }
+
+  // End a top-level value, one per line for NDJSON
+  void endLine()
+  {
+    out.put('\n');
+  }
+
+private:
+  // Put a comma before every value in an object or array but the first
+  void separate()
+  {
+    if (afterKey)
+    {
+      afterKey = false;
+      return;
+    }
+    if (!first.empty())
+    {
+      if (!first.back())
+      {
+        out.put(',');
+      }
+      first.back() = false;
+    }
+  }
+
+  void writeString(const char * data, std::size_t length)
+  {
+    out.put('"');
+    for (std::size_t i=0; i<length; i++)
+    {
+      unsigned char c = data[i];
+      if (c == '"' || c == '\\')
+      {
+        out.put('\\');
+        out.put(c);
+      }
+      else if (c < 0x20)
+      {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out.write(escaped, 6);
+      }
+      else
+      {
+        out.put(c);
+      }
+    }
+    out.put('"');
+  }
+
+  BufferedWriter& out;
+  std::vector<bool> first; // no value yet at this level
+  bool afterKey;
+};  // end class JsonWriter
+
+
+// This class reads a roster dump ("name speed" per line) from a stream one
+// person at a time, through a fixed buffer, so a roster of any length can
+// be read without holding it in memory.  A record's name points into the
+// buffer and is only valid until the next call to next().
+class PeopleStream
+{
+public:
+  PeopleStream(std::istream& is) : in(is), buffer(STREAM_BUFFER_SIZE), pos(0), filled(0),
+                                   lineNumber(0), bad(false)
+  {
+  }
+
+  // Get the next person.  Returns false at the end of the stream, or on a
+  // bad line (then failed() is true).
+  bool next(DumpRecord& record)
+  {
+    while (true)
+    {
+      const char * line = buffer.data() + pos;
+      const char * lineEnd = static_cast<const char *>(std::memchr(line, '\n', filled - pos));
+
+      if (lineEnd == nullptr)
+      {
+        // Only part of a line is buffered: move it to the front and read
+        // more, growing the buffer if one line fills all of it
+        if (!in)
+        {
+          if (pos == filled)
+          {
+            return false;
+          }
+          lineEnd = buffer.data() + filled; // the last line has no newline
+        }
+        else
+        {
+          std::memmove(buffer.data(), line, filled - pos);
+          filled -= pos;
+          pos = 0;
+          if (filled == buffer.size())
+          {
+            buffer.resize(buffer.size() * 2);
+          }
+          in.read(buffer.data() + filled, buffer.size() - filled);
+          filled += in.gcount();
+          Stats::global().addBytesRead(in.gcount());
+          continue;
+        }
+      }
+
+      lineNumber++;
+      pos = lineEnd - buffer.data() + (lineEnd < buffer.data() + filled ? 1 : 0);
+
+      bool blank;
+      if (!parseDumpLine(line, lineEnd, record, blank))
+      {
+        bad = true;
+        return false;
+      }
+      if (!blank)
+      {
+        return true;
+      }
+    }
+  } // end PeopleStream::next()
+
+  bool failed() const
+  {
+    return bad;
+  }
+
+  // The line of the last person read, or of the bad line
+  int line() const
+  {
+    return lineNumber;
+  }
+
+private:
+  std::istream& in;
+  std::vector<char> buffer;
+  std::size_t pos;    // start of the unread part of the buffer
+  std::size_t filled; // end of the data in the buffer
+  int lineNumber;
+  bool bad;
+};  // end class PeopleStream
+
+
+// This class aggregates a roster that is too long to keep: it only counts
+// how many people have each speed.  Both crossing methods depend on nothing
+// but the sorted speeds, so the totals can still be computed at the end, in
+// memory proportional to the number of distinct speeds.
+// Totals are 64-bit here, since an unbounded roster can exceed MAXINT.
+class SpeedHistogram
+{
+public:
+  SpeedHistogram() : counts(), people(0), sum(0)
+  {
+  }
+
+  void add(int speed)
+  {
+    counts[speed]++;
+    people++;
+    sum += speed;
+  }
+
+  long long size() const
+  {
+    return people;
+  }
+
+  // The Naive Method: everyone crosses with the fastest person, who
+  // returns after every crossing but the last
+  long long naiveTotal() const
+  {
+    if (people <= 1)
+    {
+      return sum;
+    }
+    long long fastest = counts.begin()->first;
+    return (sum - fastest) + (people - 2) * fastest;
+  } // end SpeedHistogram::naiveTotal()
+
+  // The Shielding Method: the same rounds as Bridge::planOptimally(),
+  // taking the two slowest people each time.  A run of people with the same
+  // speed gives identical rounds, so each run costs O(1).
+  long long optimalTotal() const
+  {
+    if (people <= 3)
+    {
+      return people == 2 ? secondFastest() : sum;
+    }
+
+    long long s0 = counts.begin()->first;
+    long long s1 = secondFastest();
+
+    // The rounds take the slowest 2*rounds people, leaving 2 or 3
+    long long rounds = (people - 2) / 2;
+    long long remaining = 2 * rounds;
+    long long totalSpeed = 0;
+
+    long long pendingTop = 0; // the slowest person of a round still open
+    bool pending = false;
+    for (std::map<int, long long>::const_reverse_iterator it = counts.rbegin();
+         remaining > 0; ++it)
+    {
+      long long speed = it->first;
+      long long k = std::min(it->second, remaining);
+      remaining -= k;
+
+      if (pending)
+      {
+        totalSpeed += roundTime(s0, s1, pendingTop, speed);
+        pending = false;
+        k--;
+      }
+      totalSpeed += (k / 2) * roundTime(s0, s1, speed, speed);
+      if (k % 2 == 1)
+      {
+        pendingTop = speed;
+        pending = true;
+      }
+    }
+
+    // Handle the 2 or 3 people left
+    if (people % 2 == 0)
+    {
+      return totalSpeed + finalTime(2, s0, s1, 0LL);
+    }
+    return totalSpeed + finalTime(3, s0, s1, thirdFastest());
+  } // end SpeedHistogram::optimalTotal()
+
+private:
+  // The speed of the k-th fastest person (0-based), k < people
+  long long kthFastest(long long k) const
+  {
+    for (std::map<int, long long>::const_iterator it = counts.begin(); ; ++it)
+    {
+      if (k < it->second)
+      {
+        return it->first;
+      }
+      k -= it->second;
+    }
+  }
+
+  long long secondFastest() const
+  {
+    return kthFastest(1);
+  }
+
+  long long thirdFastest() const
+  {
+    return kthFastest(2);
+  }
+
+  std::map<int, long long> counts; // number of people with each speed
+  long long people;
+  long long sum;
+};  // end class SpeedHistogram
+
+
+// This class keeps the speeds of everyone who has arrived at the bridge in
+// sorted order, as a treap (a randomized balanced binary search tree), so
+// the optimal total for everyone present can be updated in O(log N) per
+// arrival instead of re-sorting.
+//
+// With the speeds sorted s[0] <= ... <= s[n-1], each Shielding round for
+// the slowest person "top" and the next slowest "next" costs
+//   roundTime(s0, s1, top, next) = min(s1 + s0 + top + s1, top + s0 + next + s0)
+//                                = top + 2*s0 + min(2*s1 - s0, next)
+// The rounds take the people at ranks m..n-1, where m (2 or 3) people are
+// left at the end, and the tops and nexts alternate by rank.  So the total
+// only needs sums of the speeds at odd or even ranks over a range of ranks,
+// plus the rank where speeds reach 2*s1 - s0.  Every node stores the size of
+// its subtree and the sums of its speeds at even and odd ranks within the
+// subtree, which answers both in one walk down the tree.
+class ArrivalTree
+{
+public:
+  ArrivalTree() : nodes(), root(NONE), seed(2463534242u)
+  {
+  }
+
+  void insert(int speed)
+  {
+    Node node;
+    node.speed = speed;
+    node.priority = nextRandom();
+    node.left = NONE;
+    node.right = NONE;
+    nodes.push_back(node);
+    int added = nodes.size() - 1;
+    update(added);
+
+    // Split at the speed, with equal speeds staying on the left
+    int less, greater;
+    split(root, speed, less, greater);
+    root = merge(merge(less, added), greater);
+  } // end ArrivalTree::insert()
+
+  long long size() const
+  {
+    return count(root);
+  }
+
+  // The optimal total for everyone who has arrived so far
+  long long optimalTotal() const
+  {
+    long long n = size();
+    if (n <= 3)
+    {
+      return finalTime(n, n > 0 ? speedAt(0) : 0LL, n > 1 ? speedAt(1) : 0LL, n > 2 ? speedAt(2) : 0LL);
+    }
+
+    long long s0 = speedAt(0);
+    long long s1 = speedAt(1);
+    long long rounds = (n - 2) / 2;
+    long long m = n - 2 * rounds;
+    long long threshold = 2 * s1 - s0;
+
+    // The slowest person of each round is at a rank with the parity of n-1,
+    // the next slowest at a rank with the parity of n
+    long long total = rangeSum(m, n, (n - 1) % 2) + 2 * rounds * s0;
+
+    // Next slowest people below the threshold count at their own speed, the
+    // rest at the threshold
+    long long below = std::max(m, std::min(n, countBelow(threshold)));
+    total += rangeSum(m, below, n % 2);
+    total += threshold * rangeCount(below, n, n % 2);
+
+    // Handle the 2 or 3 people left
+    return total + finalTime(m, s0, s1, m == 3 ? speedAt(2) : 0LL);
+  } // end ArrivalTree::optimalTotal()
+
+private:
+  static const int NONE = -1;
+
+  struct Node
+  {
+    int speed;
+    unsigned int priority;
+    int left;
+    int right;
+    long long count;
+    long long sum[2]; // speeds at even and odd ranks within the subtree
+  };
+
+  long long count(int t) const
+  {
+    return (t == NONE) ? 0 : nodes[t].count;
+  }
+
+  long long sum(int t, int parity) const
+  {
+    return (t == NONE) ? 0 : nodes[t].sum[parity];
+  }
+
+  // Recompute a node's totals from its children.  The node itself is at
+  // rank L within its subtree, and the right subtree starts at rank L+1.
+  void update(int t)
+  {
+    Node& node = nodes[t];
+    long long L = count(node.left);
+    node.count = L + 1 + count(node.right);
+    for (int p=0; p<2; p++)
+    {
+      node.sum[p] = sum(node.left, p)
+                  + ((L % 2 == p) ? node.speed : 0)
+                  + sum(node.right, (p + L + 1) % 2);
+    }
+  }
+
+  // Split t into the speeds <= speed and the speeds > speed
+  void split(int t, int speed, int& less, int& greater)
+  {
+    if (t == NONE)
+    {
+      less = NONE;
+      greater = NONE;
+    }
+    else if (nodes[t].speed <= speed)
+    {
+      split(nodes[t].right, speed, nodes[t].right, greater);
+      less = t;
+      update(t);
+    }
+    else
+    {
+      split(nodes[t].left, speed, less, nodes[t].left);
+      greater = t;
+      update(t);
+    }
+  }
+
+  // Join two trees where every speed in a is <= every speed in b
+  int merge(int a, int b)
+  {
+    if (a == NONE)
+    {
+      return b;
+    }
+    if (b == NONE)
+    {
+      return a;
+    }
+    if (nodes[a].priority > nodes[b].priority)
+    {
+      nodes[a].right = merge(nodes[a].right, b);
+      update(a);
+      return a;
+    }
+    nodes[b].left = merge(a, nodes[b].left);
+    update(b);
+    return b;
+  }
+
+  // The speed at rank k (0 is the fastest), k < size()
+  long long speedAt(long long k) const
+  {
+    int t = root;
+    while (true)
+    {
+      long long L = count(nodes[t].left);
+      if (k < L)
+      {
+        t = nodes[t].left;
+      }
+      else if (k == L)
+      {
+        return nodes[t].speed;
+      }
+      else
+      {
+        k -= L + 1;
+        t = nodes[t].right;
+      }
+    }
+  }
+
+  // The sum of the speeds at ranks [0, k) that have the given parity
+  long long prefixSum(long long k, int parity) const
+  {
+    long long total = 0;
+    long long offset = 0; // rank of the current subtree's first node
+    int t = root;
+    while (t != NONE && k > 0)
+    {
+      long long L = count(nodes[t].left);
+      if (k <= L)
+      {
+        t = nodes[t].left;
+        continue;
+      }
+      total += sum(nodes[t].left, (parity + offset) % 2);
+      if ((offset + L) % 2 == parity)
+      {
+        total += nodes[t].speed;
+      }
+      k -= L + 1;
+      offset += L + 1;
+      t = nodes[t].right;
+    }
+    return total;
+  }
+
+  long long rangeSum(long long lo, long long hi, int parity) const
+  {
+    return (hi <= lo) ? 0 : prefixSum(hi, parity) - prefixSum(lo, parity);
+  }
+
+  // The number of ranks in [lo, hi) with the given parity
+  static long long rangeCount(long long lo, long long hi, int parity)
+  {
+    if (hi <= lo)
+    {
+      return 0;
+    }
+    return (hi - parity + 1) / 2 - (lo - parity + 1) / 2;
+  }
+
+  // The number of people faster than the given speed
+  long long countBelow(long long speed) const
+  {
+    long long below = 0;
+    int t = root;
+    while (t != NONE)
+    {
+      if (nodes[t].speed < speed)
+      {
+        below += count(nodes[t].left) + 1;
+        t = nodes[t].right;
+      }
+      else
+      {
+        t = nodes[t].left;
+      }
+    }
+    return below;
+  }
+
+  // xorshift32, good enough for treap priorities
+  unsigned int nextRandom()
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+  }
+
+  std::vector<Node> nodes;
+  int root;
+  unsigned int seed;
+};  // end class ArrivalTree
+
+
+// This class splits a roster across several bridges, each with its own
+// torch, to minimize the makespan: the longest time any one bridge takes.
+// A bridge's time is the Shielding Method's total for the people on it.
+//
+// Take a group made of two shuttlers f0 <= f1 and a run s[l..r) of the
+// sorted speeds, all slower than the shuttlers.  Each Shielding round costs
+//   roundTime(f0, f1, top, next) = top + f0 + min(2*f1, f0 + next)
+// where top and next are the two slowest people left.  The tops and the
+// nexts are every other speed counting from the slow end.  The rounds where
+// f0 + next < 2*f1 are the ones with the fastest nexts.  With prefix sums
+// over every other speed, a group's time therefore costs O(log N), and no
+// candidate partition is ever solved again from scratch.
+//
+// The heuristic gives bridge b the shuttlers s[2b] and s[2b+1].  The rest
+// of the sorted roster is cut into one contiguous run per bridge, and the
+// slowest run goes to the fastest shuttlers.  A binary search on the
+// makespan finds the smallest one at which runs grown greedily from the
+// slow end cover everyone.  Every count of bridges in use is tried, since
+// shuttlers are people who could otherwise have been in a run.  Rosters of
+// up to EXACT_PARTITION_MAX people are then searched exhaustively.
+class Partition
+{
+public:
+  // speeds must be sorted fastest to slowest
+  Partition(const std::vector<int>& sortedSpeeds, int bridgeCount)
+    : speeds(sortedSpeeds), everyOther(sortedSpeeds.size() + 2, 0),
+      assignment(sortedSpeeds.size(), 0), times(std::max(bridgeCount, 1), 0),
+      exact(false)
+  {
+    int n = speeds.size();
+    for (int i=0; i<n; i++)
+    {
+      everyOther[i+2] = everyOther[i] + speeds[i];
+    }
+
+    if (n <= times.size())
+    {
+      // Everyone crosses alone on their own bridge; no one can do better
+      // than the slowest person's time.
+      for (int i=0; i<n; i++)
+      {
+        assignment[i] = i;
+      }
+      exact = true;
+    }
+    else
+    {
+      splitRuns();
+      if (n <= EXACT_PARTITION_MAX)
+      {
+        searchExactly();
+        exact = true;
+      }
+    }
+    computeTimes();
+  }
+
+  int bridges() const
+  {
+    return times.size();
+  }
+
+  // The bridge person i of the sorted roster crosses on
+  int bridgeOf(int i) const
+  {
+    return assignment[i];
+  }
+
+  long long bridgeTime(int b) const
+  {
+    return times[b];
+  }
+
+  long long makespan() const
+  {
+    return *std::max_element(times.begin(), times.end());
+  }
+
+  // Whether the makespan is known to be the smallest possible
+  bool isExact() const
+  {
+    return exact;
+  }
+
+  // The Shielding Method's total for m speeds sorted fastest to slowest
+  static long long groupTime(const int * s, int m)
+  {
+    if (m <= 1)
+    {
+      return m == 1 ? s[0] : 0;
+    }
+    long long total = 0;
+    while (m >= 4)
+    {
+      total += roundTime<long long>(s[0], s[1], s[m-1], s[m-2]);
+      m -= 2;
+    }
+    return total + finalTime<long long>(m, s[0], s[1], m == 3 ? s[2] : 0);
+  } // end Partition::groupTime()
+
+private:
+  // The time of shuttlers f0 <= f1 with the run speeds[l..r), in O(log N)
+  long long runTime(int f0, int f1, int l, int r) const
+  {
+    int k = r - l;
+    int rounds = k / 2;
+    int low = r - 2 * rounds; // the fastest of the nexts
+
+    long long total = (k % 2 == 1) ? f0 + f1 + speeds[l] : f1;
+    if (rounds == 0)
+    {
+      return total;
+    }
+
+    // Tops are speeds[low+1], speeds[low+3], ..., speeds[r-1]
+    total += everyOther[r+1] - everyOther[low+1];
+    total += static_cast<long long>(rounds) * f0;
+
+    // Nexts are speeds[low], speeds[low+2], ..., speeds[r-2]; the ones below
+    // 2*f1 - f0 make the Naive round cheaper
+    int cheap = std::lower_bound(speeds.begin() + low, speeds.begin() + r, 2 * f1 - f0) - speeds.begin();
+    int count = std::min(rounds, (cheap - low + 1) / 2);
+    total += everyOther[low + 2*count] - everyOther[low] + static_cast<long long>(count) * f0;
+    total += static_cast<long long>(rounds - count) * 2 * f1;
+    return total;
+  } // end Partition::runTime()
+
+  // Cut the people after the shuttlers of `used` bridges into runs whose
+  // times are at most limit.  Each run starts where the slower one before
+  // it stopped.  Returns false if the runs can't cover everyone.
+  bool fitRuns(int used, long long limit, std::vector<int>& starts) const
+  {
+    int r = speeds.size();
+    for (int b=0; b<used; b++)
+    {
+      int f0 = speeds[2*b], f1 = speeds[2*b+1];
+      if (runTime(f0, f1, r, r) > limit)
+      {
+        return false;
+      }
+
+      // The longest run ending at r that fits.  The run's people are all
+      // slower than the shuttlers, so its time only grows as l goes lower.
+      int lo = 2 * used, hi = r;
+      while (lo < hi)
+      {
+        int mid = lo + (hi - lo) / 2;
+        if (runTime(f0, f1, mid, r) <= limit)
+        {
+          hi = mid;
+        }
+        else
+        {
+          lo = mid + 1;
+        }
+      }
+      starts[b] = lo;
+      r = lo;
+    }
+    return r == 2 * used;
+  } // end Partition::fitRuns()
+
+  // The heuristic: the best contiguous runs over every count of bridges.
+  // Using them all is usually best, so that is tried first, and any other
+  // count that can't beat it costs a single fitRuns().
+  void splitRuns()
+  {
+    int n = speeds.size();
+    long long best = runTime(speeds[0], speeds[1], 2, n) + 1; // one bridge
+    for (int used=std::min<int>(times.size(), n / 2); used>=1; used--)
+    {
+      std::vector<int> starts(used);
+      long long lo = speeds[n-1];
+      long long hi = best - 1;
+      if (!fitRuns(used, hi, starts))
+      {
+        continue;
+      }
+      while (lo < hi)
+      {
+        long long mid = lo + (hi - lo) / 2;
+        if (fitRuns(used, mid, starts))
+        {
+          hi = mid;
+        }
+        else
+        {
+          lo = mid + 1;
+        }
+      }
+
+      best = lo;
+      fitRuns(used, lo, starts);
+      int end = n;
+      for (int b=0; b<used; b++)
+      {
+        assignment[2*b] = b;
+        assignment[2*b+1] = b;
+        for (int i=starts[b]; i<end; i++)
+        {
+          assignment[i] = b;
+        }
+        end = starts[b];
+      }
+    }
+  } // end Partition::splitRuns()
+
+  // Try every assignment of people to bridges, slowest person first, and
+  // keep the best.  Bridges are interchangeable, so a person only ever opens
+  // the next unused bridge.  A branch stops as soon as a bridge's lower
+  // bound reaches the best makespan found.
+  void searchExactly()
+  {
+    computeTimes();
+    long long best = makespan();
+    std::vector<int> current(speeds.size());
+    std::vector<std::vector<int> > groups(times.size());
+    search(speeds.size() - 1, 0, current, groups, best);
+  } // end Partition::searchExactly()
+
+  void search(int i, int used, std::vector<int>& current,
+              std::vector<std::vector<int> >& groups, long long& best)
+  {
+    if (i < 0)
+    {
+      long long worst = 0;
+      for (int b=0; b<used; b++)
+      {
+        worst = std::max(worst, descendingTime(groups[b]));
+      }
+      if (worst < best)
+      {
+        best = worst;
+        assignment = current;
+      }
+      return;
+    }
+
+    for (int b=0; b<=used && b<groups.size(); b++)
+    {
+      groups[b].push_back(speeds[i]);
+      current[i] = b;
+      if (lowerBound(groups[b]) < best)
+      {
+        search(i - 1, std::max(used, b + 1), current, groups, best);
+      }
+      groups[b].pop_back();
+    }
+  } // end Partition::search()
+
+  // A lower bound on the time of a bridge that has these people, listed
+  // slowest first, and possibly faster ones still to come.  A fast person
+  // joining can make a bridge quicker, so its current time is no bound.
+  // But at most two people cross at once, so the trips forward take at least
+  // every other speed from the slowest, and each trip but the last needs a
+  // return of at least the fastest speed of all.
+  long long lowerBound(const std::vector<int>& group) const
+  {
+    long long bound = 0;
+    for (int j=0; j<group.size(); j+=2)
+    {
+      bound += group[j];
+    }
+    return bound + static_cast<long long>((group.size() + 1) / 2 - 1) * speeds[0];
+  } // end Partition::lowerBound()
+
+  // groupTime() of speeds listed slowest first
+  static long long descendingTime(const std::vector<int>& group)
+  {
+    int sorted[EXACT_PARTITION_MAX];
+    std::reverse_copy(group.begin(), group.end(), sorted);
+    return groupTime(sorted, group.size());
+  }
+
+  // Each bridge's time from the assignment
+  void computeTimes()
+  {
+    std::vector<std::vector<int> > groups(times.size());
+    for (int i=0; i<speeds.size(); i++)
+    {
+      groups[assignment[i]].push_back(speeds[i]);
+    }
+    for (int b=0; b<times.size(); b++)
+    {
+      times[b] = groupTime(groups[b].data(), groups[b].size());
+    }
+  } // end Partition::computeTimes()
+
+  std::vector<int> speeds;
+  std::vector<long long> everyOther; // everyOther[i+2] = speeds[i] + everyOther[i]
+  std::vector<int> assignment;       // the bridge of each person
+  std::vector<long long> times;      // the time of each bridge
+  bool exact;
+};  // end class Partition
+
+
+// This class represents the info about a person.
+// The name and speed members are private, and have get and set functions.
+// There is a member function to print a Person.
+// The name lives in the NamePool, so copying a Person never allocates.
+class Person
+{
+public:
+  Person() : speed(0), weight(0), returns(true)
+  {
+    name.data = "";
+    name.length = 0;
+  }
+
+  Person(std::string n, int s) : name(NamePool::global().intern(n.data(), n.size())), speed(s),
+    weight(0), returns(true)
+  {
+  }
+
+  // This operator is for sorting
+  bool operator<(const Person& other) const
+  {
+    return (speed < other.speed);
+  }
+
+  void print(std::ostream& os) const
+  {
+    // Print a Person in this format:  (Fred,12)
+    os << "(";
+    os.write(name.data, name.length);
+    os << "," << speed << ")";
+  }
+
+  // The same format, for the buffered text output
+  void write(BufferedWriter& out) const
+  {
+    out.put('(');
+    out.write(name.data, name.length);
+    out.put(',');
+    out.write(static_cast<long long>(speed));
+    out.put(')');
+  }
+
+  void setName(const std::string& n)
+  {
+    name = NamePool::global().intern(n.data(), n.size());
+  }
+
+  // For parsers that already have the characters in a buffer
+  void setName(const char * data, std::size_t length)
+  {
+    name = NamePool::global().intern(data, length);
+  }
+
+  void setSpeed(int s)
+  {
+    speed = s;
+  }
+
+  std::string getName() const
+  {
+    return std::string(name.data, name.length);
+  }
+
+  NameRef getNameRef() const
+  {
+    return name;
+  }
+
+  int getSpeed() const
+  {
+    return speed;
+  }
+
+  void setWeight(int w)
+  {
+    weight = w;
+  }
+
+  // Counts against --max-load; 0 unless the roster gives one
+  int getWeight() const
+  {
+    return weight;
+  }
+
+  void setCanReturn(bool r)
+  {
+    returns = r;
+  }
+
+  // False for people who cross once and won't bring the torch back
+  bool canReturn() const
+  {
+    return returns;
+  }
+
+private:
+  NameRef name;
+  int speed; // the time to cross the bridge, in minutes
+  int weight;
+  bool returns;
+};  // end class Person
+
+// helper function to print Person within a stream
+std::ostream& operator<<(std::ostream& os, const Person& p)
+{
+  p.print(os);
+  return os;
+};
+
+
+// One step of a schedule: one or two people cross with the torch, or one
+// person returns with it.  People are indexes into the roster the schedule
+// was made for.
+struct Step
+{
+  enum Kind { CROSS, RETURN };
+
+  Kind kind;
+  int first;
+  int second; // the other person crossing, or -1 if first crosses alone
+  int time;   // minutes this step takes
+
+  static Step crossing(int first, int second, int time)
+  {
+    Step step;
+    step.kind = CROSS;
+    step.first = first;
+    step.second = second;
+    step.time = time;
+    return step;
+  }
+
+  static Step returning(int person, int time)
+  {
+    Step step;
+    step.kind = RETURN;
+    step.first = person;
+    step.second = -1;
+    step.time = time;
+    return step;
+  }
+
+  // Print a step in this format:  (B,2) and (A,1) cross
+  void print(std::ostream& os, const std::vector<Person>& roster) const
+  {
+    if (kind == RETURN)
+    {
+      os << roster[first] << " returns";
+    }
+    else if (second < 0)
+    {
+      os << roster[first] << " crosses";
+    }
+    else
+    {
+      os << roster[first] << " and " << roster[second] << " cross";
+    }
+  }
+
+  void write(BufferedWriter& out, const std::vector<Person>& roster) const
+  {
+    roster[first].write(out);
+    if (kind == RETURN)
+    {
+      out.write(" returns");
+    }
+    else if (second < 0)
+    {
+      out.write(" crosses");
+    }
+    else
+    {
+      out.write(" and ");
+      roster[second].write(out);
+      out.write(" cross");
+    }
+  }
+};
+
+
+// This class is a Shielding Method schedule in compact form.
+// For a roster sorted fastest to slowest, the schedule is fully described
+// by one bit per round: whether the round's two slowest people cross
+// together (Shielding) or each with the fastest person (Naive).  Steps are
+// produced on demand from those bits, either by iterating or by random
+// access to step k, so a consumer that only needs the first few moves or a
+// window never pays for the rest.
+//
+// Each round is 4 steps.  When 2 or 3 people are left (or fewer to begin
+// with) the final steps are:
+//   1 person:  (0) crosses
+//   2 people:  (1) and (0) cross
+//   3 people:  (2) and (0) cross, (0) returns, (1) and (0) cross
+// The roster must outlive the schedule and stay in the same order.
+class Schedule
+{
+public:
+  Schedule(const std::vector<Person>& sortedPeople) :
+    roster(&sortedPeople), shielding(), totalTime(0)
+  {
+    int n = roster->size();
+    int rounds = (n >= 4) ? (n - 2) / 2 : 0;
+    shielding.assign(rounds, false);
+  }
+
+  int rounds() const
+  {
+    return shielding.size();
+  }
+
+  // True if the round uses the Shielding Method, false for Naive
+  bool isShielding(int round) const
+  {
+    return shielding[round];
+  }
+
+  void setShielding(int round, bool shield)
+  {
+    shielding[round] = shield;
+  }
+
+  // The total time, as set by whoever made the decisions
+  long long total() const
+  {
+    return totalTime;
+  }
+
+  void setTotal(long long t)
+  {
+    totalTime = t;
+  }
+
+  const std::vector<Person>& people() const
+  {
+    return *roster;
+  }
+
+  // The Shielding Method's schedule and total for people sorted fastest to
+  // slowest
+  static Schedule optimal(const std::vector<Person>& sortedPeople)
+  {
+    Schedule schedule(sortedPeople);
+    long long totalSpeed = 0;
+    int n = sortedPeople.size();
+
+    // Keep sending the two slowest people over the bridge,
+    // as long as there are at least 4 total people left.
+    for (int round=0; round<schedule.rounds(); round++)
+    {
+      // See how long it would take using each method: the Shielding Method
+      // sends the two slowest people together, and the Naive Method pairs
+      // each of them with the fastest person
+      long long f0 = sortedPeople[0].getSpeed();
+      long long f1 = sortedPeople[1].getSpeed();
+      long long top = sortedPeople[n-1].getSpeed();
+      long long next = sortedPeople[n-2].getSpeed();
+      schedule.setShielding(round, isShieldingRound(f0, f1, top, next));
+      totalSpeed += ::roundTime(f0, f1, top, next);
+
+      // the two slowest people are now across
+      n -= 2;
+    }
+
+    // Handle the cases where there are 0 to 3 people left
+    totalSpeed += finalTime<long long>(n, n > 0 ? sortedPeople[0].getSpeed() : 0,
+                            n > 1 ? sortedPeople[1].getSpeed() : 0,
+                            n > 2 ? sortedPeople[2].getSpeed() : 0);
+
+    schedule.setTotal(totalSpeed);
+    return schedule;
+  } // end Schedule::optimal()
+
+  // The number of steps in the whole schedule
+  long long size() const
+  {
+    int left = roster->size() - 2 * rounds();
+    return 4LL * rounds() + (left == 3 ? 3 : (left > 0 ? 1 : 0));
+  }
+
+  // Step k of the schedule, 0 <= k < size(), in O(1)
+  Step step(long long k) const
+  {
+    int n = roster->size();
+    Step s;
+    s.second = -1;
+
+    if (k < 4LL * rounds())
+    {
+      int round = k / 4;
+      int slowest = n - 1 - 2 * round;
+      int pos = k % 4;
+      if (isShielding(round))
+      {
+        // (1) and (0) cross, (0) returns, the two slowest cross, (1) returns
+        int firsts[4] = {1, 0, slowest, 1};
+        s.first = firsts[pos];
+        s.second = (pos == 0) ? 0 : (pos == 2) ? slowest - 1 : -1;
+      }
+      else
+      {
+        // each of the two slowest crosses with (0), who returns each time
+        int firsts[4] = {slowest, 0, slowest - 1, 0};
+        s.first = firsts[pos];
+        s.second = (pos % 2 == 0) ? 0 : -1;
+      }
+      s.kind = (pos % 2 == 0) ? Step::CROSS : Step::RETURN;
+    }
+    else
+    {
+      int pos = k - 4LL * rounds();
+      int left = n - 2 * rounds();
+      if (left == 1)
+      {
+        s.first = 0;
+        s.kind = Step::CROSS;
+      }
+      else if (left == 2)
+      {
+        s.first = 1;
+        s.second = 0;
+        s.kind = Step::CROSS;
+      }
+      else
+      {
+        int firsts[3] = {2, 0, 1};
+        s.first = firsts[pos];
+        s.second = (pos == 1) ? -1 : 0;
+        s.kind = (pos == 1) ? Step::RETURN : Step::CROSS;
+      }
+    }
+
+    s.time = (*roster)[s.first].getSpeed();
+    if (s.second >= 0)
+    {
+      s.time = std::max(s.time, (*roster)[s.second].getSpeed());
+    }
+    return s;
+  } // end Schedule::step()
+
+  // Forward iterator over the steps, which also tracks the time elapsed
+  // when each step starts
+  class Iterator
+  {
+  public:
+    Iterator(const Schedule& s, long long k) : schedule(&s), index(k), startTime(0)
+    {
+    }
+
+    Step operator*() const
+    {
+      return schedule->step(index);
+    }
+
+    Iterator& operator++()
+    {
+      startTime += schedule->step(index).time;
+      index++;
+      return *this;
+    }
+
+    bool operator!=(const Iterator& other) const
+    {
+      return index != other.index;
+    }
+
+    long long position() const
+    {
+      return index;
+    }
+
+    // Minutes elapsed before this step starts
+    long long elapsed() const
+    {
+      return startTime;
+    }
+
+  private:
+    friend class Schedule;
+    const Schedule * schedule;
+    long long index;
+    long long startTime;
+  };
+
+  Iterator begin() const
+  {
+    return Iterator(*this, 0);
+  }
+
+  Iterator end() const
+  {
+    return Iterator(*this, size());
+  }
+
+  // An iterator positioned at step k.  Whole rounds before k are skipped in
+  // O(1) each to find the elapsed time, without producing their steps.
+  Iterator at(long long k) const
+  {
+    Iterator it(*this, 0);
+    long long round = 0;
+    while (round < rounds() && 4 * (round + 1) <= k)
+    {
+      it.startTime += roundTime(round);
+      round++;
+    }
+    it.index = 4 * round;
+    while (it.index < k)
+    {
+      ++it;
+    }
+    return it;
+  } // end Schedule::at()
+
+  // The time a round takes with its current decision
+  long long roundTime(int round) const
+  {
+    const std::vector<Person>& s = *roster;
+    int n = s.size();
+    int slowest = n - 1 - 2 * round;
+    if (isShielding(round))
+    {
+      return shieldingRoundTime<long long>(s[0].getSpeed(), s[1].getSpeed(), s[slowest].getSpeed());
+    }
+    return naiveRoundTime<long long>(s[0].getSpeed(), s[slowest].getSpeed(), s[slowest-1].getSpeed());
+  }
+
+private:
+  const std::vector<Person> * roster;
+  std::vector<bool> shielding; // one bit per round
+  long long totalTime;
+};  // end class Schedule
+
+
+// This class ranks the schedules that make their own round decisions,
+// fastest first, starting with the Shielding Method's.  Switching a round
+// to its other method costs the difference between the two, so a
+// schedule's total is the optimal total plus the costs of the rounds it
+// switches, and ranking the schedules means ranking sets of rounds by their
+// summed cost.  With the rounds sorted by cost, each set comes from exactly
+// one parent set, by adding the next round after its costliest one or by
+// moving that round to the next one, so a heap of the frontier gives each
+// next schedule in O(log K) time, plus O(N) to write its decisions.  A
+// round where both methods take the same time gives two schedules with
+// equal totals.
+class ScheduleRanking
+{
+public:
+  ScheduleRanking(const Schedule& optimal)
+    : best(optimal), order(), cost(), sets(), frontier(), started(false)
+  {
+    Schedule probe(optimal);
+    for (int round=0; round<probe.rounds(); round++)
+    {
+      long long kept = probe.roundTime(round);
+      probe.setShielding(round, !probe.isShielding(round));
+      cost.push_back(probe.roundTime(round) - kept);
+      order.push_back(round);
+    }
+    std::stable_sort(order.begin(), order.end(), CostOrder(cost));
+  }
+
+  // Make schedule the next fastest one; returns false once every schedule
+  // has been ranked
+  bool next(Schedule& schedule)
+  {
+    if (!started)
+    {
+      started = true;
+      schedule = best;
+      if (!order.empty())
+      {
+        push(best.total() + cost[order[0]], 0, -1);
+      }
+      return true;
+    }
+    if (frontier.empty())
+    {
+      return false;
+    }
+
+    int id = frontier.top().second;
+    frontier.pop();
+    RoundSet set = sets[id];
+    if (set.last + 1 < order.size())
+    {
+      long long following = cost[order[set.last + 1]];
+      push(set.total + following, set.last + 1, id);
+      push(set.total - cost[order[set.last]] + following, set.last + 1, set.parent);
+    }
+
+    schedule = best;
+    for (int s=id; s>=0; s=sets[s].parent)
+    {
+      int round = order[sets[s].last];
+      schedule.setShielding(round, !schedule.isShielding(round));
+    }
+    schedule.setTotal(set.total);
+    return true;
+  } // end ScheduleRanking::next()
+
+private:
+  // A set of switched rounds: its costliest round, as a position in order,
+  // and the set of the others
+  struct RoundSet
+  {
+    long long total;
+    int last;
+    int parent; // -1 for none
+  };
+
+  struct CostOrder
+  {
+    const std::vector<long long>& cost;
+    CostOrder(const std::vector<long long>& c) : cost(c) {}
+    bool operator()(int a, int b) const
+    {
+      return cost[a] < cost[b];
+    }
+  };
+
+  void push(long long total, int last, int parent)
+  {
+    RoundSet set;
+    set.total = total;
+    set.last = last;
+    set.parent = parent;
+    sets.push_back(set);
+    frontier.push(std::make_pair(total, static_cast<int>(sets.size()) - 1));
+  }
+
+  typedef std::pair<long long, int> Entry; // (total, index into sets)
+
+  Schedule best;
+  std::vector<int> order;        // rounds, cheapest switch first
+  std::vector<long long> cost;   // of switching each round
+  std::vector<RoundSet> sets;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > frontier;
+  bool started;
+};  // end class ScheduleRanking
+
+
+// This class is a natural number of any size, for counts that overflow 64
+// bits.  It only needs multiplying by small factors and printing, so it is
+// kept in base 10^9 digits, least significant first.  Factors are gathered
+// into one word until it would overflow, so the digits are only walked once
+// per word rather than once per factor.
+class BigNatural
+{
+public:
+  BigNatural(unsigned int value) : limbs(), pending(1)
+  {
+    limbs.push_back(value % BASE);
+    if (value >= BASE)
+    {
+      limbs.push_back(value / BASE);
+    }
+  }
+
+  void multiply(unsigned int factor)
+  {
+    if (pending * factor > std::numeric_limits<unsigned int>::max())
+    {
+      apply(pending);
+      pending = 1;
+    }
+    pending *= factor;
+  }
+
+  // The number in decimal
+  std::string str() const
+  {
+    BigNatural whole(*this);
+    whole.apply(whole.pending);
+    std::ostringstream os;
+    os << whole.limbs.back();
+    for (int i=whole.limbs.size()-2; i>=0; i--)
+    {
+      os << std::setw(9) << std::setfill('0') << whole.limbs[i];
+    }
+    return os.str();
+  }
+
+private:
+  void apply(unsigned long long factor)
+  {
+    if (factor == 0)
+    {
+      limbs.assign(1, 0);
+      return;
+    }
+    unsigned long long carry = 0;
+    for (int i=0; i<limbs.size(); i++)
+    {
+      unsigned long long product = limbs[i] * factor + carry;
+      limbs[i] = product % BASE;
+      carry = product / BASE;
+    }
+    while (carry != 0)
+    {
+      limbs.push_back(carry % BASE);
+      carry /= BASE;
+    }
+  }
+
+  static const unsigned int BASE = 1000000000;
+  std::vector<unsigned int> limbs;
+  unsigned long long pending; // factors not yet applied, below 2^32
+};  // end class BigNatural
+
+
+// The binary schedule format, about an order of magnitude smaller than the
+// text and much faster to write.  All numbers are unsigned LEB128 varints.
+//
+//   "XBS1"                       magic and format version
+//   N                            number of people
+//   N x (length, name, speed)    the roster, in schedule order
+//   S                            number of steps
+//   S x step                     the steps
+//
+// A step is (first << 2 | kind), then the second person if kind is 0, then
+// the step's time.  kind is 0 for two people crossing, 1 for one person
+// crossing and 2 for a return.  Storing each step's time (the difference
+// between consecutive cumulative times) keeps the varints short; the reader
+// adds them back up.
+//
+// ScheduleEncoder writes the format as a stream: the header, then one step
+// at a time, so a schedule never has to be expanded in memory.
+class ScheduleEncoder
+{
+public:
+  ScheduleEncoder(BufferedWriter& w) : out(w)
+  {
+  }
+
+  void writeHeader(const std::vector<Person>& roster, long long steps)
+  {
+    out.write(SCHEDULE_MAGIC, sizeof(SCHEDULE_MAGIC));
+    out.writeVarint(roster.size());
+    for (int i=0; i<roster.size(); i++)
+    {
+      NameRef name = roster[i].getNameRef();
+      out.writeVarint(name.length);
+      out.write(name.data, name.length);
+      out.writeVarint(roster[i].getSpeed());
+    }
+    out.writeVarint(steps);
+  }
+
+  void writeStep(const Step& step)
+  {
+    unsigned long long kind = (step.kind == Step::RETURN) ? 2 : (step.second < 0 ? 1 : 0);
+    out.writeVarint((static_cast<unsigned long long>(step.first) << 2) | kind);
+    if (kind == 0)
+    {
+      out.writeVarint(step.second);
+    }
+    out.writeVarint(step.time);
+  }
+
+  void writeSchedule(const Schedule& schedule)
+  {
+    writeHeader(schedule.people(), schedule.size());
+    for (Schedule::Iterator it = schedule.begin(); it != schedule.end(); ++it)
+    {
+      writeStep(*it);
+    }
+  }
+
+private:
+  BufferedWriter& out;
+};  // end class ScheduleEncoder
+
+
+// This class reads the binary schedule format back, one step at a time.
+// Every read is checked against the end of the buffer.
+class ScheduleDecoder
+{
+public:
+  ScheduleDecoder(const char * begin, const char * end) : pos(begin), last(end), bad(false)
+  {
+  }
+
+  // Read the magic and the roster.  Returns false if they are malformed,
+  // or if the step count is more than the rest of the buffer can hold.
+  bool readHeader(std::vector<Person>& roster, long long& steps)
+  {
+    if (last - pos < static_cast<long>(sizeof(SCHEDULE_MAGIC)) ||
+        std::memcmp(pos, SCHEDULE_MAGIC, sizeof(SCHEDULE_MAGIC)) != 0)
+    {
+      return false;
+    }
+    pos += sizeof(SCHEDULE_MAGIC);
+
+    unsigned long long people = readVarint();
+    for (unsigned long long i=0; i<people && !bad; i++)
+    {
+      unsigned long long length = readVarint();
+      if (bad || length > static_cast<unsigned long long>(last - pos))
+      {
+        return false;
+      }
+      Person p;
+      p.setName(pos, length);
+      pos += length;
+      unsigned long long speed = readVarint();
+      if (bad || speed == 0 || speed > static_cast<unsigned long long>(std::numeric_limits<int>::max()))
+      {
+        return false;
+      }
+      p.setSpeed(speed);
+      roster.push_back(p);
+    }
+    // Each step takes two bytes at least, its head and its time
+    unsigned long long count = readVarint();
+    if (bad || count > static_cast<unsigned long long>(last - pos) / 2)
+    {
+      return false;
+    }
+    steps = count;
+    return true;
+  } // end ScheduleDecoder::readHeader()
+
+  // Read the next step.  Returns false if it is malformed or refers to
+  // someone outside the roster.  Like the speeds in readHeader(), every
+  // value is checked at its full 64 bits before it is narrowed to an int.
+  bool readStep(int people, Step& step)
+  {
+    unsigned long long head = readVarint();
+    unsigned long long kind = head & 3;
+    unsigned long long second = (kind == 0) ? readVarint() : 0;
+    unsigned long long time = readVarint();
+    if (bad || kind > 2 || (head >> 2) >= static_cast<unsigned long long>(people)
+        || second >= static_cast<unsigned long long>(people)
+        || time > static_cast<unsigned long long>(std::numeric_limits<int>::max()))
+    {
+      return false;
+    }
+    step.first = head >> 2;
+    step.second = (kind == 0) ? static_cast<int>(second) : -1;
+    step.kind = (kind == 2) ? Step::RETURN : Step::CROSS;
+    step.time = time;
+    return true;
+  }
+
+private:
+  unsigned long long readVarint()
+  {
+    unsigned long long value = 0;
+    for (int shift=0; shift<64; shift+=7)
+    {
+      if (pos == last)
+      {
+        break;
+      }
+      unsigned char byte = *pos++;
+      value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+      {
+        return value;
+      }
+    }
+    bad = true;
+    return 0;
+  }
+
+  const char * pos;
+  const char * last;
+  bool bad;
+};  // end class ScheduleDecoder
+
+
+// This class is the space of crossing states that the exact searches
+// explore.  People with the same speed are interchangeable, so a state only
+// records how many people of each speed class are still on the near bank,
+// and the side the torch is on.  The counts are packed as the digits of one
+// mixed-radix number: class c contributes a digit from 0 to its size.  A
+// roster of hundreds of people in a few speed classes then has a small
+// state space, where one bit per person would have 2^N states.  Forward
+// moves take two people across (or the last one alone), and return moves
+// bring one person back.  At the slower person's pace, a pair with the
+// fastest person on the near bank is never slower than the other alone, so
+// no one else needs to cross alone.  Under another pair cost it can be, and
+// forward moves also take each person across alone.
+//
+// Steps still name people.  The near-bank people of a class are always the
+// first ones of the class in the sorted roster, so the one who crosses is
+// the last of those, and the one who returns is the next after them.
+//
+// lowerBound() is admissible.  With the torch on the near bank, pick one
+// fastest person who can return, F, and count the trips with and without
+// F.  F alternates directions, so F crosses once more than F returns if F
+// is still on the near bank, or as often otherwise.  Every other return
+// takes at least the second fastest speed of those who can return, and the
+// one who returns has to cross again, at a pace no faster than anyone
+// crossing.  All of this counts each trip at its slowest person's pace.  A trip
+// with F takes one other person at most, and a trip without F takes one or
+// two.  So, for r returns by others, the crossings to make are the near-bank
+// people besides F plus r more at the second fastest speed.  Packing them
+// slowest first into pairs, one per trip without F, with the rest alone on
+// F's trips, gives the least time for those trips.  F should return only as
+// often as the trips need, and the bound is the least time over every r.
+// With the torch on the far bank, someone from there brings it back first,
+// and the bound is the least over who that is.  On a full near bank the
+// bound equals the Shielding Method's total.  If no one can return, only
+// one trip is left to make, so more than two on the near bank can't finish.
+class CrossingStates
+{
+public:
+  // A move from a state: the step taken and the state it leads to
+  struct Move
+  {
+    unsigned long long next;
+    Step step;
+  };
+
+  // speeds must be sorted fastest to slowest.  By default everyone starts
+  // on the near bank and can return; startsNear and canReturn can say who
+  // does instead.  Within each speed, the people who can return must come
+  // first, and then within those groups the people who start near.
+  CrossingStates(const std::vector<int>& sortedSpeeds,
+                 const std::vector<bool>& startsNear = std::vector<bool>(),
+                 const std::vector<bool>& canReturn = std::vector<bool>())
+    : people(sortedSpeeds.size()), classSpeed(), classSize(), classFirst(),
+      classStart(), classReturns(), firstReturner(-1), secondReturnSpeed(-1),
+      place(), stateCount(2), pairTime(), pairExtra(0), boundNum(1), boundDen(1)
+  {
+    for (int i=0; i<people; i++)
+    {
+      bool returns = canReturn.empty() || canReturn[i];
+      if (i == 0 || sortedSpeeds[i] != sortedSpeeds[i-1] || returns != classReturns.back())
+      {
+        classSpeed.push_back(sortedSpeeds[i]);
+        classSize.push_back(0);
+        classFirst.push_back(i);
+        classStart.push_back(0);
+        classReturns.push_back(returns);
+      }
+      classSize.back()++;
+      if (startsNear.empty() || startsNear[i])
+      {
+        classStart.back()++;
+      }
+    }
+
+    // The two fastest people who can return
+    for (int c=0; c<classSpeed.size() && secondReturnSpeed < 0; c++)
+    {
+      if (!classReturns[c])
+      {
+        continue;
+      }
+      if (firstReturner < 0)
+      {
+        firstReturner = c;
+        if (classSize[c] > 1)
+        {
+          secondReturnSpeed = classSpeed[c];
+        }
+      }
+      else
+      {
+        secondReturnSpeed = classSpeed[c];
+      }
+    }
+
+    // Stop counting once the states can't be numbered in 63 bits
+    for (int c=0; c<classSize.size(); c++)
+    {
+      place.push_back(stateCount / 2);
+      if (stateCount <= (1ULL << 62) / (classSize[c] + 1))
+      {
+        stateCount *= classSize[c] + 1;
+      }
+      else
+      {
+        stateCount = std::numeric_limits<unsigned long long>::max();
+      }
+    }
+  }
+
+  // Take the times of pairs from a cost functor instead of the slower
+  // person's pace; anyone alone still takes their own speed.  The pace
+  // bound holds for every schedule, lone crossings and all, but a schedule
+  // under the cost differs from its pace only on its trips of two.  Each
+  // such trip takes one person more across than it takes the torch, and a
+  // lone crossing or a return takes as many as it brings, so the number of
+  // trips of two left is fixed by the state, whoever crosses alone.  The
+  // lower bound therefore adds the least extra time of a pair over its
+  // pace, which may be negative, for each of those trips.  And when some
+  // pair is faster than its pace, every step takes at least the least ratio
+  // of the two times its pace, so the pace bound scaled by that ratio is a
+  // bound too.  It takes whichever is larger.  Only for states that can be
+  // numbered, and only the searches use it: descend() assumes the slower
+  // person's pace.
+  template <typename Cost>
+  void setPairCost(const Cost& cost)
+  {
+    int classes = classSpeed.size();
+    pairExtra = std::numeric_limits<long long>::max();
+    boundNum = 1;
+    boundDen = 1;
+    if (stateCount == std::numeric_limits<unsigned long long>::max())
+    {
+      pairExtra = 0;
+      return;
+    }
+    pairTime.assign(classes * classes, 0);
+    for (int slow=0; slow<classes; slow++)
+    {
+      for (int fast=0; fast<=slow; fast++)
+      {
+        long long time = cost(classSpeed[fast], classSpeed[slow]);
+        pairTime[slow * classes + fast] = time;
+        if (fast == slow && classSize[slow] < 2)
+        {
+          continue;
+        }
+        pairExtra = std::min(pairExtra, time - classSpeed[slow]);
+        if (time * boundDen < boundNum * classSpeed[slow])
+        {
+          boundNum = time;
+          boundDen = classSpeed[slow];
+        }
+      }
+    }
+    if (people < 2)
+    {
+      pairExtra = 0;
+    }
+  } // end CrossingStates::setPairCost()
+
+  int size() const
+  {
+    return people;
+  }
+
+  // The number of states, counting both torch sides; the maximum value if
+  // there are too many to number
+  unsigned long long count() const
+  {
+    return stateCount;
+  }
+
+  // The starting people on the near bank with the torch
+  unsigned long long start() const
+  {
+    unsigned long long near = 0;
+    for (int c=0; c<classSize.size(); c++)
+    {
+      near += classStart[c] * place[c];
+    }
+    return (near << 1) | 1;
+  }
+
+  // No one left on the near bank
+  static bool isGoal(unsigned long long state)
+  {
+    return state == 0;
+  }
+
+  // The moves from a state, slowest pairs and fastest returners first, so a
+  // depth-first search finds good schedules early
+  void moves(unsigned long long state, std::vector<Move>& out) const
+  {
+    out.clear();
+    int classes = classSize.size();
+    int near[MAX_CLASSES];
+    int nearPeople = counts(state, near);
+    Move move;
+    if (state & 1)
+    {
+      move.step.kind = Step::CROSS;
+      if (nearPeople == 1)
+      {
+        int c = 0;
+        while (near[c] == 0)
+        {
+          c++;
+        }
+        move.step.first = classFirst[c];
+        move.step.second = -1;
+        move.step.time = classSpeed[c];
+        move.next = 0;
+        out.push_back(move);
+        return;
+      }
+      for (int slow=classes-1; slow>=0; slow--)
+      {
+        if (near[slow] == 0)
+        {
+          continue;
+        }
+        for (int fast=0; fast<=slow; fast++)
+        {
+          if (near[fast] == 0 || (fast == slow && near[slow] < 2))
+          {
+            continue;
+          }
+          move.step.first = classFirst[slow] + near[slow] - 1;
+          move.step.second = classFirst[fast] + near[fast] - 1 - (fast == slow ? 1 : 0);
+          move.step.time = pairTime.empty() ? classSpeed[slow] : pairTime[slow * classes + fast];
+          move.next = state - ((place[slow] + place[fast]) << 1) - 1;
+          out.push_back(move);
+        }
+      }
+      if (pairTime.empty())
+      {
+        return;
+      }
+
+      // Under a pair cost, crossing alone may be quicker than any pair
+      move.step.second = -1;
+      for (int c=classes-1; c>=0; c--)
+      {
+        if (near[c] > 0)
+        {
+          move.step.first = classFirst[c] + near[c] - 1;
+          move.step.time = classSpeed[c];
+          move.next = state - (place[c] << 1) - 1;
+          out.push_back(move);
+        }
+      }
+    }
+    else
+    {
+      move.step.kind = Step::RETURN;
+      move.step.second = -1;
+      for (int c=0; c<classes; c++)
+      {
+        if (near[c] < classSize[c] && classReturns[c])
+        {
+          move.step.first = classFirst[c] + near[c];
+          move.step.time = classSpeed[c];
+          move.next = state + (place[c] << 1) + 1;
+          out.push_back(move);
+        }
+      }
+    }
+  } // end CrossingStates::moves()
+
+  // A lower bound on the time left; see the class comment and
+  // setPairCost()
+  long long lowerBound(unsigned long long state) const
+  {
+    int nearPeople;
+    long long bound = paceBound(state, nearPeople);
+    if (pairTime.empty() || bound >= UNREACHABLE_TIME || nearPeople == 0)
+    {
+      return bound;
+    }
+
+    // Each trip of two takes one person more across than it takes the
+    // torch, and every other step as many, so every schedule has
+    // nearPeople - 1 of them left with the torch here, or nearPeople with it
+    // across, however many people cross alone
+    long long pairs = nearPeople - static_cast<long long>(state & 1);
+    long long extra = bound + pairs * pairExtra;
+    if (boundNum < boundDen)
+    {
+      extra = std::max(extra, bound / boundDen * boundNum + bound % boundDen * boundNum / boundDen);
+    }
+    return extra;
+  } // end CrossingStates::lowerBound()
+
+private:
+  // The lower bound when pairs cross at the slower person's pace, and the
+  // number of people on the near bank
+  long long paceBound(unsigned long long state, int& nearPeople) const
+  {
+    int near[MAX_CLASSES];
+    nearPeople = counts(state, near);
+    if (nearPeople == 0)
+    {
+      return 0;
+    }
+    if (state & 1)
+    {
+      return crossingBound(near, nearPeople);
+    }
+
+    // Someone from the far bank brings the torch back first
+    long long bound = UNREACHABLE_TIME;
+    for (int c=0; c<classSize.size(); c++)
+    {
+      if (near[c] < classSize[c] && classReturns[c])
+      {
+        near[c]++;
+        bound = std::min(bound, classSpeed[c] + crossingBound(near, nearPeople + 1));
+        near[c]--;
+      }
+    }
+    return bound;
+  } // end CrossingStates::paceBound()
+
+public:
+  // Follow the lower bound from the start to the goal without searching:
+  // at each step, take a trip and a return whose times, plus the bound
+  // after them, keep the bound.  On a full near bank the bound is the
+  // Shielding Method's total, and the people already across only make it
+  // smaller, so a schedule it leads to all the way is optimal.  Only a few
+  // trips are tried: the two slowest, the slowest with the fastest, the two
+  // fastest, or the fastest or slowest alone, and the same with the fastest
+  // who can return, each followed by the fastest or second fastest return.
+  // Returns false, with the steps so far, if none of them keeps the bound.
+  // This needs no state numbers, so it works for any number of speeds, in
+  // O(N) steps of O(N) each.
+  bool descend(std::vector<Step>& steps) const
+  {
+    steps.clear();
+    int classes = classSize.size();
+    std::vector<int> near(classStart);
+    int nearPeople = 0;
+    for (int c=0; c<classes; c++)
+    {
+      nearPeople += near[c];
+    }
+    if (nearPeople == 0)
+    {
+      return true;
+    }
+    long long bound = crossingBound(&near[0], nearPeople);
+
+    while (nearPeople > 2)
+    {
+      // The near bank's two slowest and two fastest people, by class
+      int slow = classes - 1;
+      while (near[slow] == 0)
+      {
+        slow--;
+      }
+      int nextSlow = slow;
+      if (near[slow] < 2)
+      {
+        nextSlow--;
+        while (near[nextSlow] == 0)
+        {
+          nextSlow--;
+        }
+      }
+      int fast = 0;
+      while (near[fast] == 0)
+      {
+        fast++;
+      }
+      int nextFast = fast;
+      if (near[fast] < 2)
+      {
+        nextFast++;
+        while (near[nextFast] == 0)
+        {
+          nextFast++;
+        }
+      }
+
+      // and the fastest who can return, if any is here
+      int shuttle = fast;
+      while (shuttle < classes && (near[shuttle] == 0 || !classReturns[shuttle]))
+      {
+        shuttle++;
+      }
+      if (shuttle == classes)
+      {
+        shuttle = fast;
+      }
+      int trips[8][2] = { {slow, nextSlow}, {slow, fast}, {nextFast, fast}, {fast, -1}, {slow, -1},
+                          {slow, shuttle}, {shuttle, -1}, {shuttle, (shuttle == fast) ? nextFast : fast} };
+
+      bool kept = false;
+      for (int t=0; t<8 && !kept; t++)
+      {
+        if (trips[t][0] == trips[t][1] && near[trips[t][0]] < 2)
+        {
+          continue;
+        }
+        Step cross = crossStep(near, trips[t][0], trips[t][1]);
+        int crossed = (trips[t][1] < 0) ? 1 : 2;
+        near[trips[t][0]]--;
+        if (crossed == 2)
+        {
+          near[trips[t][1]]--;
+        }
+
+        // The fastest two speeds on the far bank who can return
+        int returner = 0;
+        for (int r=0; r<2 && !kept; r++)
+        {
+          while (returner < classes && (near[returner] == classSize[returner] || !classReturns[returner]))
+          {
+            returner++;
+          }
+          if (returner == classes)
+          {
+            break;
+          }
+          Step back;
+          back.kind = Step::RETURN;
+          back.first = classFirst[returner] + near[returner];
+          back.second = -1;
+          back.time = classSpeed[returner];
+          near[returner]++;
+          long long after = crossingBound(&near[0], nearPeople - crossed + 1);
+          if (cross.time + back.time + after == bound)
+          {
+            steps.push_back(cross);
+            steps.push_back(back);
+            nearPeople += 1 - crossed;
+            bound = after;
+            kept = true;
+            break;
+          }
+          near[returner]--;
+          returner++; // another of the same speed would return the same
+        }
+
+        if (!kept)
+        {
+          near[trips[t][0]]++;
+          if (crossed == 2)
+          {
+            near[trips[t][1]]++;
+          }
+        }
+      }
+      if (!kept)
+      {
+        return false;
+      }
+    }
+
+    // The last one or two cross together
+    int last = classes - 1;
+    while (near[last] == 0)
+    {
+      last--;
+    }
+    int other = -1;
+    if (nearPeople == 2)
+    {
+      other = (near[last] == 2) ? last : last - 1;
+      while (near[other] == 0)
+      {
+        other--;
+      }
+    }
+    Step cross = crossStep(near, last, other);
+    steps.push_back(cross);
+    return cross.time == bound;
+  } // end CrossingStates::descend()
+
+private:
+  // Each class at least doubles the number of states, so any roster whose
+  // states can be numbered has fewer classes than this
+  static const int MAX_CLASSES = 64;
+
+  // The lower bound with the torch on the near bank, given the near-bank
+  // count of each class and their total
+  long long crossingBound(const int * near, int nearPeople) const
+  {
+    int classes = classSize.size();
+    if (firstReturner < 0)
+    {
+      // Without anyone to return, only the last one or two can cross
+      int slow = classes - 1;
+      while (slow >= 0 && near[slow] == 0)
+      {
+        slow--;
+      }
+      return (nearPeople > 2) ? UNREACHABLE_TIME : classSpeed[slow];
+    }
+    long long fastest = classSpeed[firstReturner];
+    long long secondFastest = secondReturnSpeed;
+
+    // Whether the fastest who can return is one to cross, and the others
+    // who are
+    int fastestNear = (near[firstReturner] > 0) ? 1 : 0;
+    int others = nearPeople - fastestNear;
+    int extraTrips = 1 - fastestNear;
+    long long sum = -fastestNear * fastest;
+    long long recrossing = secondFastest;
+    for (int c=classes-1; c>=0; c--)
+    {
+      int crossing = near[c] - (c == firstReturner ? fastestNear : 0);
+      sum += static_cast<long long>(near[c]) * classSpeed[c];
+      if (crossing > 0 && classSpeed[c] < recrossing)
+      {
+        recrossing = classSpeed[c];
+      }
+    }
+
+    // Try each number of returns by people other than the fastest.  The
+    // hidden speeds are the second of each pair, slowest first, walking the
+    // classes from the slowest.  Those who return cross again; counting
+    // them at no more than anyone else crossing keeps them last in the walk.
+    long long bound = UNREACHABLE_TIME;
+    long long hiddenSum = 0;
+    int hidden = 0;
+    int c = classes - 1;
+    int left = near[c] - (c == firstReturner ? fastestNear : 0);
+    int position = 0;       // of the next speed the walk reaches
+    for (int slowReturns=0; ; slowReturns++)
+    {
+      int pairs = std::min(slowReturns + extraTrips, others - extraTrips);
+      while (hidden < pairs)
+      {
+        int wanted = 2 * hidden + 1;
+        long long speed = recrossing;
+        while (position <= wanted && c >= 0)
+        {
+          if (left == 0)
+          {
+            c--;
+            left = (c >= 0) ? near[c] - (c == firstReturner ? fastestNear : 0) : 0;
+            continue;
+          }
+          if (position == wanted)
+          {
+            speed = classSpeed[c];
+          }
+          left--;
+          position++;
+        }
+        hiddenSum += speed;
+        hidden++;
+      }
+      int alone = std::max(0, others - slowReturns - 2 * extraTrips);
+      int fastReturns = std::max(0, alone - fastestNear);
+      long long time = sum + slowReturns * (secondFastest + recrossing) - hiddenSum
+                       + (2 * fastReturns + fastestNear - alone) * fastest;
+      bound = std::min(bound, time);
+      if (secondFastest < 0 || slowReturns + extraTrips >= others - extraTrips)
+      {
+        break;
+      }
+    }
+    return bound;
+  } // end CrossingStates::crossingBound()
+
+  // The step taking the last near-bank person of class a across, with the
+  // last (or, for the same class, next to last) of class b, or alone if b
+  // is -1
+  Step crossStep(const std::vector<int>& near, int a, int b) const
+  {
+    Step step;
+    step.kind = Step::CROSS;
+    step.first = classFirst[a] + near[a] - 1;
+    step.second = -1;
+    step.time = classSpeed[a];
+    if (b >= 0)
+    {
+      step.second = classFirst[b] + near[b] - 1 - (a == b ? 1 : 0);
+      step.time = std::max(classSpeed[a], classSpeed[b]);
+    }
+    return step;
+  }
+
+  // Unpack the near-bank count of each class; returns the total
+  int counts(unsigned long long state, int * near) const
+  {
+    unsigned long long digits = state >> 1;
+    int total = 0;
+    for (int c=0; c<classSize.size(); c++)
+    {
+      near[c] = digits % (classSize[c] + 1);
+      digits /= classSize[c] + 1;
+      total += near[c];
+    }
+    return total;
+  }
+
+  int people;
+  std::vector<int> classSpeed;  // the distinct speeds, fastest first
+  std::vector<int> classSize;   // how many people have each speed
+  std::vector<int> classFirst;  // the first of them in the sorted roster
+  std::vector<int> classStart;  // how many of them start on the near bank
+  std::vector<bool> classReturns; // whether they can make return trips
+  int firstReturner;            // the fastest class who can return, or -1
+  long long secondReturnSpeed;  // of the second fastest who can, or -1
+  std::vector<unsigned long long> place; // the value of one in each digit
+  unsigned long long stateCount;
+  std::vector<int> pairTime;    // [slow * classes + fast], or empty for MaxCost
+  long long pairExtra;          // the least time a pair takes over its pace
+  long long boundNum;           // the lower bound's scale, boundNum / boundDen
+  long long boundDen;
+};  // end class CrossingStates
+
+// The slower person's pace needs no table
+template <>
+inline void CrossingStates::setPairCost<MaxCost>(const MaxCost&)
+{
+  pairTime.clear();
+  pairExtra = 0;
+  boundNum = 1;
+  boundDen = 1;
+}
+
+
+// This class finds an optimal schedule by exhaustive search, as a check on
+// the Shielding Method and for variants no formula covers.  The search is
+// depth-first branch and bound over CrossingStates.  The Shielding Method's
+// schedule is the first incumbent, so only strictly shorter schedules are
+// ever explored.  A branch is cut when its time plus the lower bound on the
+// rest reaches the incumbent, or when the state was already reached at
+// least as quickly.
+class CrossingSearch
+{
+public:
+  // Start from the Shielding Method's schedule for the sorted roster
+  CrossingSearch(const Schedule& schedule)
+    : states(speedsOf(schedule)), best(schedule.total()), bestSteps(),
+      path(), choices(), reached(), expanded(0)
+  {
+    for (Schedule::Iterator it = schedule.begin(); it != schedule.end(); ++it)
+    {
+      bestSteps.push_back(*it);
+    }
+  }
+
+  // Search a given space, such as one with its own pair cost, starting
+  // from an incumbent schedule for it
+  CrossingSearch(const CrossingStates& space, const std::vector<Step>& incumbent)
+    : states(space), best(totalOf(incumbent)), bestSteps(incumbent),
+      path(), choices(), reached(), expanded(0)
+  {
+  }
+
+  // Search for a shorter schedule.  Returns true if one was found.
+  bool run()
+  {
+    long long seed = best;
+    if (states.size() > 0)
+    {
+      choices.resize(2 * states.size());
+      search(states.start(), 0);
+    }
+    return best < seed;
+  } // end CrossingSearch::run()
+
+  // The optimal total, once run() has returned
+  long long total() const
+  {
+    return best;
+  }
+
+  // An optimal schedule; people are indexes into the sorted roster
+  const std::vector<Step>& steps() const
+  {
+    return bestSteps;
+  }
+
+  // The number of states whose moves were tried
+  long long statesExpanded() const
+  {
+    return expanded;
+  }
+
+  // The speeds of a schedule's roster, in its order
+  static std::vector<int> speedsOf(const Schedule& schedule)
+  {
+    std::vector<int> speeds;
+    for (int i=0; i<schedule.people().size(); i++)
+    {
+      speeds.push_back(schedule.people()[i].getSpeed());
+    }
+    return speeds;
+  }
+
+  // The total time of some steps
+  static long long totalOf(const std::vector<Step>& steps)
+  {
+    long long total = 0;
+    for (int k=0; k<steps.size(); k++)
+    {
+      total += steps[k].time;
+    }
+    return total;
+  }
+
+private:
+  void search(unsigned long long state, long long elapsed)
+  {
+    if (CrossingStates::isGoal(state))
+    {
+      if (elapsed < best)
+      {
+        best = elapsed;
+        bestSteps = path;
+      }
+      return;
+    }
+    if (elapsed + states.lowerBound(state) >= best)
+    {
+      return;
+    }
+
+    std::unordered_map<unsigned long long, long long>::iterator seen = reached.find(state);
+    if (seen != reached.end() && seen->second <= elapsed)
+    {
+      return;
+    }
+    reached[state] = elapsed;
+    expanded++;
+
+    // One vector of moves per depth, reused
+    std::vector<CrossingStates::Move>& moves = choices[path.size()];
+    states.moves(state, moves);
+    for (int m=0; m<moves.size(); m++)
+    {
+      path.push_back(moves[m].step);
+      search(moves[m].next, elapsed + moves[m].step.time);
+      path.pop_back();
+    }
+  } // end CrossingSearch::search()
+
+  CrossingStates states;
+  long long best;            // the incumbent's total
+  std::vector<Step> bestSteps;
+  std::vector<Step> path;    // the steps to the current state
+  std::vector<std::vector<CrossingStates::Move> > choices;
+  std::unordered_map<unsigned long long, long long> reached; // state -> time
+  long long expanded;
+};  // end class CrossingSearch
+
+
+// This class is the multi-threaded exact search (--exact parallel).  It is
+// Dijkstra's algorithm over CrossingStates with integer bucket queues (Dial),
+// pruned like CrossingSearch by the incumbent and the lower bound.
+//
+// Every state belongs to one shard, chosen by a hash of the state, and each
+// worker thread owns one shard: its best-known times, parents and buckets.
+// So no shard is ever locked.  The workers advance one bucket time at a time
+// in two phases, separated by a barrier:
+//   1. each worker expands its shard's states at the current time, and
+//      appends each successor to its outbox for the successor's shard
+//   2. each worker drains the outboxes addressed to its shard
+// Each outbox has exactly one writer and one reader, in different phases,
+// so it needs no lock either.  The incumbent total is one atomic shared by
+// all workers and lowered whenever someone reaches the goal.  The search
+// ends when no shard has a state earlier than the incumbent.
+class ParallelCrossingSearch
+{
+public:
+  // Start from the Shielding Method's schedule for the sorted roster
+  ParallelCrossingSearch(const Schedule& schedule, int threadCount)
+    : states(CrossingSearch::speedsOf(schedule)), workers(std::max(threadCount, 1)),
+      best(schedule.total()), bestSteps(), shards(workers),
+      outboxes(workers * workers), next(workers), barrier(workers), expanded(0)
+  {
+    for (Schedule::Iterator it = schedule.begin(); it != schedule.end(); ++it)
+    {
+      bestSteps.push_back(*it);
+    }
+  }
+
+  // Search a given space, starting from an incumbent schedule for it
+  ParallelCrossingSearch(const CrossingStates& space, const std::vector<Step>& incumbent,
+                         int threadCount)
+    : states(space), workers(std::max(threadCount, 1)),
+      best(CrossingSearch::totalOf(incumbent)), bestSteps(incumbent), shards(workers),
+      outboxes(workers * workers), next(workers), barrier(workers), expanded(0)
+  {
+  }
+
+  // Search for a shorter schedule.  Returns true if one was found.
+  bool run()
+  {
+    long long seed = best.load();
+    if (states.size() == 0 || states.lowerBound(states.start()) >= seed)
+    {
+      return false;
+    }
+
+    unsigned long long start = states.start();
+    Shard& home = shards[owner(start)];
+    Visit visit;
+    visit.time = 0;
+    visit.parent = start;
+    home.visited[start] = visit;
+    home.buckets[0].push_back(start);
+
+    std::vector<std::thread> threads;
+    for (int w=1; w<workers; w++)
+    {
+      threads.push_back(std::thread(&ParallelCrossingSearch::work, this, w));
+    }
+    work(0);
+    for (int t=0; t<threads.size(); t++)
+    {
+      threads[t].join();
+    }
+
+    if (best.load() < seed)
+    {
+      // Follow the parents back from the goal
+      bestSteps.clear();
+      unsigned long long state = 0;
+      while (state != start)
+      {
+        const Visit& v = shards[owner(state)].visited[state];
+        bestSteps.push_back(v.step);
+        state = v.parent;
+      }
+      std::reverse(bestSteps.begin(), bestSteps.end());
+    }
+    return best.load() < seed;
+  } // end ParallelCrossingSearch::run()
+
+  long long total() const
+  {
+    return best.load();
+  }
+
+  const std::vector<Step>& steps() const
+  {
+    return bestSteps;
+  }
+
+  long long statesExpanded() const
+  {
+    return expanded.load();
+  }
+
+private:
+  // How a state was first reached at its best-known time
+  struct Visit
+  {
+    long long time;
+    unsigned long long parent;
+    Step step;
+  };
+
+  // A successor on its way to its shard
+  struct Arrival
+  {
+    unsigned long long state;
+    unsigned long long parent;
+    long long time;
+    Step step;
+  };
+
+  struct Shard
+  {
+    std::unordered_map<unsigned long long, Visit> visited;
+    std::map<long long, std::vector<unsigned long long> > buckets; // by time
+  };
+
+  // Padded so that workers appending to neighbouring outboxes don't share a
+  // cache line
+  struct Outbox
+  {
+    std::vector<Arrival> arrivals;
+    char padding[64];
+  };
+
+  // A reusable barrier that spins on an atomic generation count
+  class SpinBarrier
+  {
+  public:
+    SpinBarrier(int n) : count(n), waiting(0), generation(0)
+    {
+    }
+
+    void wait()
+    {
+      unsigned int gen = generation.load(std::memory_order_acquire);
+      if (waiting.fetch_add(1, std::memory_order_acq_rel) == count - 1)
+      {
+        waiting.store(0, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        return;
+      }
+      while (generation.load(std::memory_order_acquire) == gen)
+      {
+        std::this_thread::yield();
+      }
+    }
+
+  private:
+    int count;
+    std::atomic<int> waiting;
+    std::atomic<unsigned int> generation;
+  };
+
+  // The shard a state belongs to (splitmix64 finalizer)
+  int owner(unsigned long long state) const
+  {
+    state ^= state >> 30;
+    state *= 0xbf58476d1ce4e5b9ULL;
+    state ^= state >> 27;
+    state *= 0x94d049bb133111ebULL;
+    state ^= state >> 31;
+    return state % workers;
+  }
+
+  // One worker thread's loop; see the class comment
+  void work(int w)
+  {
+    Shard& shard = shards[w];
+    std::vector<CrossingStates::Move> moves;
+    long long count = 0;
+    long long now = 0;
+
+    while (true)
+    {
+      // Phase 1: expand this shard's states at time now
+      std::map<long long, std::vector<unsigned long long> >::iterator bucket = shard.buckets.find(now);
+      if (bucket != shard.buckets.end())
+      {
+        for (int k=0; k<bucket->second.size(); k++)
+        {
+          unsigned long long state = bucket->second[k];
+          if (shard.visited[state].time != now)
+          {
+            continue; // reached again sooner since it was queued
+          }
+          count++;
+          states.moves(state, moves);
+          for (int m=0; m<moves.size(); m++)
+          {
+            Arrival arrival;
+            arrival.state = moves[m].next;
+            arrival.parent = state;
+            arrival.time = now + moves[m].step.time;
+            arrival.step = moves[m].step;
+            if (CrossingStates::isGoal(arrival.state))
+            {
+              // Keep it if it ties the incumbent, which it may have just set
+              long long incumbent = best.load();
+              while (arrival.time < incumbent &&
+                     !best.compare_exchange_weak(incumbent, arrival.time))
+              {
+              }
+              if (arrival.time > best.load())
+              {
+                continue;
+              }
+            }
+            else if (arrival.time + states.lowerBound(arrival.state) >= best.load())
+            {
+              continue;
+            }
+            outboxes[w * workers + owner(arrival.state)].arrivals.push_back(arrival);
+          }
+        }
+        shard.buckets.erase(bucket);
+      }
+      barrier.wait();
+
+      // Phase 2: take in the successors sent to this shard.  The incumbent
+      // can't change in this phase, so every worker sees the same one.
+      long long incumbent = best.load();
+      for (int p=0; p<workers; p++)
+      {
+        std::vector<Arrival>& arrivals = outboxes[p * workers + w].arrivals;
+        for (int a=0; a<arrivals.size(); a++)
+        {
+          const Arrival& arrival = arrivals[a];
+          std::unordered_map<unsigned long long, Visit>::iterator seen = shard.visited.find(arrival.state);
+          if (seen != shard.visited.end() && seen->second.time <= arrival.time)
+          {
+            continue;
+          }
+          Visit& visit = shard.visited[arrival.state];
+          visit.time = arrival.time;
+          visit.parent = arrival.parent;
+          visit.step = arrival.step;
+          if (!CrossingStates::isGoal(arrival.state))
+          {
+            shard.buckets[arrival.time].push_back(arrival.state);
+          }
+        }
+        arrivals.clear();
+      }
+      next[w] = shard.buckets.empty() ? std::numeric_limits<long long>::max()
+                                      : shard.buckets.begin()->first;
+      barrier.wait();
+
+      // Every worker moves on to the same, earliest time
+      now = *std::min_element(next.begin(), next.end());
+      if (now >= incumbent)
+      {
+        break;
+      }
+    }
+    expanded += count;
+  } // end ParallelCrossingSearch::work()
+
+  CrossingStates states;
+  int workers;
+  std::atomic<long long> best; // the incumbent's total
+  std::vector<Step> bestSteps;
+  std::vector<Shard> shards;
+  std::vector<Outbox> outboxes; // [producer * workers + consumer]
+  std::vector<long long> next;  // each shard's earliest time
+  SpinBarrier barrier;
+  std::atomic<long long> expanded;
+};  // end class ParallelCrossingSearch
+
+
+// This class is the memory-bounded exact search (--exact ida): iterative
+// deepening A* over CrossingStates.  Each iteration is a depth-first search
+// that cuts every branch whose time plus lower bound exceeds a threshold.
+// The first threshold is the start's lower bound, and each next one is the
+// smallest value that was cut, so the first schedule found is optimal.
+// Once the threshold reaches the Shielding Method's total, nothing shorter
+// exists.  Apart from the path, the only memory is a transposition table of
+// fixed size: a state already expanded in this iteration at no later time
+// is skipped.  A table slot holds one state, and newer states replace
+// older ones.
+class IdaCrossingSearch
+{
+public:
+  // Start from the Shielding Method's schedule, with a table of about
+  // tableBytes
+  IdaCrossingSearch(const Schedule& schedule, std::size_t tableBytes)
+    : states(CrossingSearch::speedsOf(schedule)), best(schedule.total()),
+      bestSteps(), path(), choices(), table(), iteration(0), expanded(0)
+  {
+    for (Schedule::Iterator it = schedule.begin(); it != schedule.end(); ++it)
+    {
+      bestSteps.push_back(*it);
+    }
+    allocate(tableBytes);
+  }
+
+  // Search a given space, starting from an incumbent schedule for it
+  IdaCrossingSearch(const CrossingStates& space, const std::vector<Step>& incumbent,
+                    std::size_t tableBytes)
+    : states(space), best(CrossingSearch::totalOf(incumbent)), bestSteps(incumbent),
+      path(), choices(), table(), iteration(0), expanded(0)
+  {
+    allocate(tableBytes);
+  }
+
+  // Search a given space for a schedule shorter than incumbent, which has
+  // no steps of its own
+  IdaCrossingSearch(const CrossingStates& space, long long incumbent, std::size_t tableBytes)
+    : states(space), best(incumbent), bestSteps(), path(), choices(), table(),
+      iteration(0), expanded(0)
+  {
+    allocate(tableBytes);
+  }
+
+  // Search for a shorter schedule.  Returns true if one was found.
+  bool run()
+  {
+    long long seed = best;
+    if (states.size() == 0)
+    {
+      return false;
+    }
+
+    choices.resize(2 * states.size());
+    unsigned long long start = states.start();
+    long long threshold = states.lowerBound(start);
+    while (threshold < best)
+    {
+      iteration++;
+      long long next = std::numeric_limits<long long>::max();
+      if (search(start, 0, threshold, next))
+      {
+        break;
+      }
+      threshold = next;
+    }
+    return best < seed;
+  } // end IdaCrossingSearch::run()
+
+  long long total() const
+  {
+    return best;
+  }
+
+  const std::vector<Step>& steps() const
+  {
+    return bestSteps;
+  }
+
+  long long statesExpanded() const
+  {
+    return expanded;
+  }
+
+  // The number of thresholds tried
+  unsigned int iterations() const
+  {
+    return iteration;
+  }
+
+private:
+  struct Slot
+  {
+    unsigned long long state;
+    long long time;         // when it was expanded
+    unsigned int iteration; // in which iteration; 0 for never
+  };
+
+  // A power of two slots, at least one, and no more than twice the states
+  void allocate(std::size_t tableBytes)
+  {
+    std::size_t slots = 1;
+    while (slots * 2 * sizeof(Slot) <= tableBytes && slots < states.count())
+    {
+      slots *= 2;
+    }
+    Slot empty;
+    empty.state = 0;
+    empty.time = 0;
+    empty.iteration = 0;
+    table.assign(slots, empty);
+  }
+
+  // Returns true when it reaches the goal.  next collects the smallest
+  // time plus bound that was over the threshold.
+  bool search(unsigned long long state, long long elapsed, long long threshold, long long& next)
+  {
+    long long estimate = elapsed + states.lowerBound(state);
+    if (estimate > threshold)
+    {
+      next = std::min(next, estimate);
+      return false;
+    }
+    if (CrossingStates::isGoal(state))
+    {
+      best = elapsed;
+      bestSteps = path;
+      return true;
+    }
+
+    // splitmix64 finalizer, for the slot
+    unsigned long long hash = state;
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    Slot& slot = table[hash & (table.size() - 1)];
+    if (slot.state == state && slot.iteration == iteration && slot.time <= elapsed)
+    {
+      return false;
+    }
+    slot.state = state;
+    slot.time = elapsed;
+    slot.iteration = iteration;
+    expanded++;
+
+    // Returns and crossings again can make the path longer than two steps
+    // a person, so the move lists grow with it.  They are indexed, not
+    // held by reference, since growing moves them.
+    int depth = path.size();
+    if (depth == choices.size())
+    {
+      choices.resize(depth + 1);
+    }
+    states.moves(state, choices[depth]);
+    for (int m=0; m<choices[depth].size(); m++)
+    {
+      CrossingStates::Move move = choices[depth][m];
+      path.push_back(move.step);
+      if (search(move.next, elapsed + move.step.time, threshold, next))
+      {
+        return true;
+      }
+      path.pop_back();
+    }
+    return false;
+  } // end IdaCrossingSearch::search()
+
+  CrossingStates states;
+  long long best;            // the incumbent's total
+  std::vector<Step> bestSteps;
+  std::vector<Step> path;    // the steps to the current state
+  std::vector<std::vector<CrossingStates::Move> > choices;
+  std::vector<Slot> table;   // the transposition table
+  unsigned int iteration;
+  long long expanded;
+};  // end class IdaCrossingSearch
+
+
+// This class plans the crossings when the Shielding Method's assumptions
+// don't hold: some people start on the far bank, where they can bring the
+// torch back for the others, or some people can't make return trips.  The
+// torch starts on the near bank.  CrossingStates::descend() follows the
+// lower bound to the goal, which takes O(N^2) time and gives an optimal
+// schedule.  If no trip it tries keeps the bound, as can happen when people
+// who can't return are faster than those who can, the iterative deepening
+// search finds the schedule instead, when the speeds are few enough to
+// number the states.
+class ConstrainedPlan
+{
+public:
+  ConstrainedPlan(const std::vector<Person>& near, const std::vector<Person>& across,
+                  std::size_t tableBytes)
+    : roster(), planSteps(), totalTime(0), feasible(true), searched(false),
+      found(true), expanded(0)
+  {
+    // Sorted by speed, then those who can return first, then those on the
+    // near bank first
+    std::vector<std::pair<Person, bool> > everyone;
+    for (int i=0; i<near.size(); i++)
+    {
+      everyone.push_back(std::make_pair(near[i], true));
+    }
+    for (int i=0; i<across.size(); i++)
+    {
+      everyone.push_back(std::make_pair(across[i], false));
+    }
+    std::stable_sort(everyone.begin(), everyone.end(), StatesOrder());
+
+    std::vector<int> speeds;
+    std::vector<bool> startsNear;
+    std::vector<bool> canReturn;
+    bool anyReturner = false;
+    for (int i=0; i<everyone.size(); i++)
+    {
+      roster.push_back(everyone[i].first);
+      speeds.push_back(everyone[i].first.getSpeed());
+      startsNear.push_back(everyone[i].second);
+      canReturn.push_back(everyone[i].first.canReturn());
+      anyReturner = anyReturner || everyone[i].first.canReturn();
+    }
+
+    // Three or more need someone to bring the torch back
+    if (near.size() > 2 && !anyReturner)
+    {
+      feasible = false;
+      found = false;
+      return;
+    }
+
+    CrossingStates states(speeds, startsNear, canReturn);
+    if (states.descend(planSteps))
+    {
+      for (int k=0; k<planSteps.size(); k++)
+      {
+        totalTime += planSteps[k].time;
+      }
+      return;
+    }
+
+    searched = true;
+    planSteps.clear();
+    if (states.count() == std::numeric_limits<unsigned long long>::max())
+    {
+      found = false;
+      return;
+    }
+
+    // Each near-bank person crossing with one who can return, who comes
+    // back each time, is a schedule of at most two steps per person, so
+    // the search has a shorter schedule than this to find
+    long long slowest = speeds.empty() ? 0 : speeds.back();
+    IdaCrossingSearch search(states, 2 * near.size() * slowest + 1, tableBytes);
+    search.run();
+    totalTime = search.total();
+    planSteps = search.steps();
+    expanded = search.statesExpanded();
+  }
+
+  // Everyone, sorted by speed; the steps refer to them by index
+  const std::vector<Person>& people() const
+  {
+    return roster;
+  }
+
+  const std::vector<Step>& steps() const
+  {
+    return planSteps;
+  }
+
+  long long total() const
+  {
+    return totalTime;
+  }
+
+  // False if no schedule can get everyone across
+  bool isFeasible() const
+  {
+    return feasible;
+  }
+
+  // Whether the exact search was needed, and how many states it expanded
+  bool isSearched() const
+  {
+    return searched;
+  }
+
+  long long statesExpanded() const
+  {
+    return expanded;
+  }
+
+  // False if there is no schedule, or the search was needed and the speeds
+  // were too many
+  bool isFound() const
+  {
+    return found;
+  }
+
+private:
+  struct StatesOrder
+  {
+    bool operator()(const std::pair<Person, bool>& a, const std::pair<Person, bool>& b) const
+    {
+      if (a.first.getSpeed() != b.first.getSpeed())
+      {
+        return a.first.getSpeed() < b.first.getSpeed();
+      }
+      if (a.first.canReturn() != b.first.canReturn())
+      {
+        return a.first.canReturn();
+      }
+      return a.second && !b.second;
+    }
+  };
+
+  std::vector<Person> roster;
+  std::vector<Step> planSteps;
+  long long totalTime;
+  bool feasible;
+  bool searched;
+  bool found;
+  long long expanded;
+};  // end class ConstrainedPlan
+
+
+// One trip under a load limit: any number of people cross together, or one
+// returns.  People are indexes into the plan's roster, slowest first.
+struct GroupStep
+{
+  Step::Kind kind;
+  std::vector<int> people;
+  int time;   // minutes this step takes
+
+  // Write a step in this format:  (C,5), (B,2) and (A,1) cross
+  void write(BufferedWriter& out, const std::vector<Person>& roster) const
+  {
+    for (int i=0; i<people.size(); i++)
+    {
+      if (i > 0)
+      {
+        out.write((i + 1 < people.size()) ? ", " : " and ");
+      }
+      roster[people[i]].write(out);
+    }
+    if (kind == Step::RETURN)
+    {
+      out.write(" returns");
+    }
+    else if (people.size() == 1)
+    {
+      out.write(" crosses");
+    }
+    else
+    {
+      out.write(" cross");
+    }
+  }
+};
+
+
+// This class plans the crossings on a bridge rated by load instead of by
+// headcount (--max-load): any number of people cross together while their
+// weights add up to no more than the load.  Returns are one person each.
+//
+// The roster is sorted fastest first.  A few of the fastest and of the
+// lightest people are tried as shuttles, alone or in pairs.  For each
+// choice, a dynamic program over the others, slowest first, cuts them into
+// runs that cross together, in O(N^2): a run goes with a shuttle, who
+// brings the torch back, or between the two shuttles' trips, as in the
+// Shielding Method, and the last run goes with the shuttles.  Any schedule
+// the program finds is a bound, which prunes the rest.  For up to
+// EXACT_PEOPLE people, a best-first search over each set of people on the
+// near bank, cutting whatever can't beat that bound, then proves the best
+// schedule optimal or finds a better one.
+class LoadPlan
+{
+public:
+  LoadPlan(const std::vector<Person>& people, long long maxLoad)
+    : roster(people), load(maxLoad), planSteps(), totalTime(UNREACHABLE_TIME),
+      heaviest(-1), feasible(true), exact(false)
+  {
+    std::stable_sort(roster.begin(), roster.end());
+    int n = roster.size();
+    if (n == 0)
+    {
+      totalTime = 0;
+      exact = true;
+      return;
+    }
+
+    // Everyone must fit on the bridge, and unless everyone crosses at once,
+    // someone has to cross with another and bring the torch back, so the
+    // two lightest must fit together
+    long long lightest = UNREACHABLE_TIME;
+    long long nextLightest = UNREACHABLE_TIME;
+    long long everyone = 0;
+    for (int i=0; i<n; i++)
+    {
+      long long w = roster[i].getWeight();
+      everyone += w;
+      if (w > load && (heaviest < 0 || w > roster[heaviest].getWeight()))
+      {
+        heaviest = i;
+      }
+      if (w < lightest)
+      {
+        nextLightest = lightest;
+        lightest = w;
+      }
+      else if (w < nextLightest)
+      {
+        nextLightest = w;
+      }
+    }
+    if (heaviest >= 0 || (everyone > load && lightest + nextLightest > load))
+    {
+      feasible = false;
+      return;
+    }
+
+    group();
+    if (n <= EXACT_PEOPLE)
+    {
+      search();
+      exact = true;
+    }
+  }
+
+  // Everyone, sorted by speed; the steps refer to them by index
+  const std::vector<Person>& people() const
+  {
+    return roster;
+  }
+
+  const std::vector<GroupStep>& steps() const
+  {
+    return planSteps;
+  }
+
+  long long total() const
+  {
+    return totalTime;
+  }
+
+  long long maxLoad() const
+  {
+    return load;
+  }
+
+  // False if no schedule gets everyone across under the load
+  bool isFeasible() const
+  {
+    return feasible;
+  }
+
+  // The heaviest person over the load, or -1 if everyone fits
+  int overweight() const
+  {
+    return heaviest;
+  }
+
+  // Whether the total is proven optimal
+  bool isExact() const
+  {
+    return exact;
+  }
+
+private:
+  // The exact search keeps two numbers for each of 2^(N+1) states, and
+  // tries every group that fits, about 3^N of them in all
+  static const int EXACT_PEOPLE = 16;
+
+  // How many of the fastest, and of the lightest, the grouping tries as
+  // shuttles
+  static const int SHUTTLES = 6;
+
+  // Try each choice of shuttles, keeping the fastest schedule
+  void group()
+  {
+    int n = roster.size();
+    std::vector<int> byWeight;
+    for (int i=0; i<n; i++)
+    {
+      byWeight.push_back(i);
+    }
+    std::stable_sort(byWeight.begin(), byWeight.end(), LighterFirst(roster));
+
+    std::vector<int> candidates;
+    for (int i=0; i<n && i<SHUTTLES; i++)
+    {
+      candidates.push_back(i);
+      candidates.push_back(byWeight[i]);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (int a=0; a<candidates.size(); a++)
+    {
+      groupWith(candidates[a], -1);
+      for (int b=a+1; b<candidates.size(); b++)
+      {
+        groupWith(candidates[a], candidates[b]);
+      }
+    }
+  } // end LoadPlan::group()
+
+  // The dynamic program with shuttle x, and y if it isn't -1, where x is
+  // the faster.  Each run is the next people by speed, slowest first.
+  void groupWith(int x, int y)
+  {
+    long long shuttleWeight = roster[x].getWeight() + ((y >= 0) ? roster[y].getWeight() : 0);
+    if (shuttleWeight > load)
+    {
+      return;
+    }
+    long long shuttleTime = roster[(y >= 0) ? y : x].getSpeed();
+
+    std::vector<int> rest;
+    for (int i=roster.size()-1; i>=0; i--)
+    {
+      if (i != x && i != y)
+      {
+        rest.push_back(i);
+      }
+    }
+    int m = rest.size();
+    std::vector<long long> after(m + 1, 0);   // the weight of rest[i..m)
+    for (int i=m-1; i>=0; i--)
+    {
+      after[i] = after[i+1] + roster[rest[i]].getWeight();
+    }
+
+    // cost[i] is the fastest time to take rest[0..i) across and have the
+    // torch back; the run ending at i started at from[i], and went with
+    // escort[i], or between the shuttles' trips if that is -1
+    std::vector<long long> cost(m + 1, UNREACHABLE_TIME);
+    std::vector<int> from(m + 1, -1);
+    std::vector<int> escort(m + 1, -1);
+    cost[0] = 0;
+    int finish = -1;
+    for (int i=0; i<=m; i++)
+    {
+      // Whatever is left takes at least its slowest person's time
+      long long slowest = (i < m) ? roster[rest[i]].getSpeed() : shuttleTime;
+      if (cost[i] + slowest >= totalTime)
+      {
+        continue;
+      }
+
+      // The last run: everyone left crosses with the shuttles
+      if (after[i] + shuttleWeight <= load && cost[i] + std::max(slowest, shuttleTime) < totalTime)
+      {
+        totalTime = cost[i] + std::max(slowest, shuttleTime);
+        finish = i;
+      }
+
+      long long runWeight = 0;
+      for (int j=i+1; j<=m; j++)
+      {
+        runWeight += roster[rest[j-1]].getWeight();
+        if (runWeight > load)
+        {
+          break;
+        }
+        long long runTime = roster[rest[i]].getSpeed();
+        for (int k=0; k<2; k++)
+        {
+          int s = (k == 0) ? x : y;
+          if (s >= 0 && runWeight + roster[s].getWeight() <= load)
+          {
+            long long time = cost[i] + std::max(runTime, static_cast<long long>(roster[s].getSpeed()))
+                             + roster[s].getSpeed();
+            if (time < cost[j])
+            {
+              cost[j] = time;
+              from[j] = i;
+              escort[j] = s;
+            }
+          }
+        }
+        if (y >= 0)
+        {
+          long long time = cost[i] + 2 * roster[y].getSpeed() + roster[x].getSpeed() + runTime;
+          if (time < cost[j])
+          {
+            cost[j] = time;
+            from[j] = i;
+            escort[j] = -1;
+          }
+        }
+      }
+    }
+    if (finish < 0)
+    {
+      return;
+    }
+
+    // Walk the runs back from the last one, then write them forward
+    std::vector<int> ends;
+    for (int j=finish; j>0; j=from[j])
+    {
+      ends.push_back(j);
+    }
+    planSteps.clear();
+    for (int r=ends.size()-1; r>=0; r--)
+    {
+      int j = ends[r];
+      std::vector<int> run(rest.begin() + from[j], rest.begin() + j);
+      if (escort[j] >= 0)
+      {
+        run.push_back(escort[j]);
+        addStep(Step::CROSS, run);
+        addStep(Step::RETURN, std::vector<int>(1, escort[j]));
+      }
+      else
+      {
+        std::vector<int> shuttles;
+        shuttles.push_back(y);
+        shuttles.push_back(x);
+        addStep(Step::CROSS, shuttles);
+        addStep(Step::RETURN, std::vector<int>(1, x));
+        addStep(Step::CROSS, run);
+        addStep(Step::RETURN, std::vector<int>(1, y));
+      }
+    }
+    std::vector<int> last(rest.begin() + finish, rest.end());
+    if (y >= 0)
+    {
+      last.push_back(y);
+    }
+    last.push_back(x);
+    addStep(Step::CROSS, last);
+  } // end LoadPlan::groupWith()
+
+  // The exact search's tables.  A state is the near-bank set, shifted,
+  // with the torch in bit 0.
+  typedef std::pair<long long, unsigned int> Entry;   // time plus bound, state
+  struct Tables
+  {
+    unsigned int full;                   // everyone
+    std::vector<long long> weightOf;     // of each set
+    std::vector<signed char> slowestOf;  // the slowest in each set
+    std::vector<signed char> fastestOf;  // the fastest in each set
+    std::vector<long long> best;         // the time each state is reached
+    std::vector<unsigned int> parent;    // the state before
+    std::vector<unsigned int> moved;     // the set that crossed or returned
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+  };
+
+  // Best-first search over the states, with the lower bound that the
+  // slowest on the near bank still has to cross, after the fastest across
+  // brings the torch back
+  void search()
+  {
+    int n = roster.size();
+    Tables t;
+    t.full = (1u << n) - 1;
+    t.weightOf.assign(t.full + 1, 0);
+    t.slowestOf.assign(t.full + 1, -1);
+    t.fastestOf.assign(t.full + 1, -1);
+    int high = 0;
+    for (unsigned int set=1; set<=t.full; set++)
+    {
+      if (set == (2u << high))
+      {
+        high++;
+      }
+      t.weightOf[set] = t.weightOf[set ^ (1u << high)] + roster[high].getWeight();
+      t.slowestOf[set] = high;
+      t.fastestOf[set] = (set & 1) ? 0 : t.fastestOf[set >> 1] + 1;
+    }
+    t.best.assign(2u << n, UNREACHABLE_TIME);
+    t.parent.assign(2u << n, 0);
+    t.moved.assign(2u << n, 0);
+
+    unsigned int start = (t.full << 1) | 1;
+    t.best[start] = 0;
+    t.open.push(Entry(bound(t, start), start));
+    while (!t.open.empty())
+    {
+      Entry entry = t.open.top();
+      t.open.pop();
+      unsigned int state = entry.second;
+      unsigned int near = state >> 1;
+      long long time = t.best[state];
+      if (entry.first >= totalTime)
+      {
+        return;   // nothing left beats the schedule in hand
+      }
+      if (entry.first > time + bound(t, state))
+      {
+        continue; // reached sooner since
+      }
+      if (near == 0)
+      {
+        totalTime = time;
+        planSteps.clear();
+        std::vector<unsigned int> path;
+        for (unsigned int s=state; s!=start; s=t.parent[s])
+        {
+          path.push_back(s);
+        }
+        for (int k=path.size()-1; k>=0; k--)
+        {
+          std::vector<int> group;
+          for (int i=0; i<n; i++)
+          {
+            if (t.moved[path[k]] & (1u << i))
+            {
+              group.push_back(i);
+            }
+          }
+          addStep((path[k] & 1) ? Step::RETURN : Step::CROSS, group);
+        }
+        return;
+      }
+
+      if (state & 1)
+      {
+        // Any group on the near bank that fits crosses
+        for (unsigned int set=near; set!=0; set=(set-1)&near)
+        {
+          if (t.weightOf[set] <= load)
+          {
+            relax(t, state, (near ^ set) << 1, set, time + roster[t.slowestOf[set]].getSpeed());
+          }
+        }
+      }
+      else
+      {
+        // One person across brings the torch back
+        unsigned int far = t.full & ~near;
+        for (int i=0; i<n; i++)
+        {
+          if (far & (1u << i))
+          {
+            relax(t, state, ((near | (1u << i)) << 1) | 1, 1u << i, time + roster[i].getSpeed());
+          }
+        }
+      }
+    }
+  } // end LoadPlan::search()
+
+  long long bound(const Tables& t, unsigned int state) const
+  {
+    unsigned int near = state >> 1;
+    if (near == 0)
+    {
+      return 0;
+    }
+    long long time = roster[t.slowestOf[near]].getSpeed();
+    if ((state & 1) == 0)
+    {
+      time += roster[t.fastestOf[t.full & ~near]].getSpeed();
+    }
+    return time;
+  }
+
+  // Reach next from state by moving set, if that is sooner and can still
+  // beat the schedule in hand
+  void relax(Tables& t, unsigned int state, unsigned int next, unsigned int set, long long time) const
+  {
+    long long estimate = time + bound(t, next);
+    if (time < t.best[next] && estimate < totalTime)
+    {
+      t.best[next] = time;
+      t.parent[next] = state;
+      t.moved[next] = set;
+      t.open.push(Entry(estimate, next));
+    }
+  }
+
+  // Append a step for a group, listed slowest first
+  void addStep(Step::Kind kind, std::vector<int> group)
+  {
+    std::sort(group.begin(), group.end(), std::greater<int>());
+    GroupStep step;
+    step.kind = kind;
+    step.people = group;
+    step.time = roster[group[0]].getSpeed();
+    planSteps.push_back(step);
+  }
+
+  struct LighterFirst
+  {
+    explicit LighterFirst(const std::vector<Person>& r) : roster(r)
+    {
+    }
+
+    bool operator()(int a, int b) const
+    {
+      return roster[a].getWeight() < roster[b].getWeight();
+    }
+
+    const std::vector<Person>& roster;
+  };
+
+  std::vector<Person> roster;
+  long long load;
+  std::vector<GroupStep> planSteps;
+  long long totalTime;
+  int heaviest;
+  bool feasible;
+  bool exact;
+};  // end class LoadPlan
+
+
+// One trip of a plan with several torches, and the torch it takes
+struct TorchStep
+{
+  Step step;
+  int torch;
+};
+
+
+// This class plans the crossings when there are several torches
+// (--torches).  The bridge still holds two people at a time, so the trips
+// go one after another, but a trip only needs a torch on the side it
+// starts from: with t torches, t trips can go forward before anyone has to
+// bring one back.  Two people alone could share the bridge, each with a
+// torch, but the plan never overlaps trips.
+//
+// Each torch is a single-torch problem of its own.  A torch given to the
+// two slowest people left takes them across in the slower one's time,
+// where their Shielding round takes longer, so every torch but one takes
+// the slowest pair left across.  The fastest people left cross with the
+// last torch in the rounds Schedule::optimal() chooses.  For up to
+// EXACT_TORCH_PEOPLE people, a best-first search over each set of people on
+// the near bank, with each number of torches there, then proves that plan
+// optimal or finds a faster one.
+class TorchPlan
+{
+public:
+  TorchPlan(const std::vector<Person>& people, int torchCount)
+    : roster(people), torchTotal(std::max(torchCount, 1)), planSteps(),
+      totalTime(0), exact(false)
+  {
+    std::stable_sort(roster.begin(), roster.end());
+    std::vector<Step> steps = pairUp();
+    if (roster.size() <= EXACT_TORCH_PEOPLE)
+    {
+      search(steps);
+      exact = true;
+    }
+    takeTorches(steps);
+  }
+
+  // Everyone, sorted by speed; the steps refer to them by index
+  const std::vector<Person>& people() const
+  {
+    return roster;
+  }
+
+  int torches() const
+  {
+    return torchTotal;
+  }
+
+  const std::vector<TorchStep>& steps() const
+  {
+    return planSteps;
+  }
+
+  long long total() const
+  {
+    return totalTime;
+  }
+
+  // Whether the total is proven optimal for trips one at a time
+  bool isExact() const
+  {
+    return exact;
+  }
+
+private:
+  // The exact search keeps three numbers for each of 2^N sets of people
+  // times the number of torches on the near bank
+  static const int EXACT_TORCH_PEOPLE = 16;
+
+  // The slowest pairs, each with a torch of their own, then the rest with
+  // the last torch
+  std::vector<Step> pairUp()
+  {
+    int n = roster.size();
+    int pairs = std::min(torchTotal - 1, n / 2);
+    std::vector<Step> steps;
+    for (int p=0; p<pairs; p++)
+    {
+      int slowest = n - 1 - 2 * p;
+      steps.push_back(Step::crossing(slowest, slowest - 1, roster[slowest].getSpeed()));
+    }
+
+    // The rest are the fastest, so their indexes are the same in both
+    std::vector<Person> rest(roster.begin(), roster.end() - 2 * pairs);
+    Schedule schedule = Schedule::optimal(rest);
+    for (long long k=0; k<schedule.size(); k++)
+    {
+      steps.push_back(schedule.step(k));
+    }
+    totalTime = CrossingSearch::totalOf(steps);
+    return steps;
+  } // end TorchPlan::pairUp()
+
+  // The exact search's tables.  A state is the near-bank set times the
+  // number of torches that can be there, plus the torches there.
+  typedef std::pair<long long, unsigned int> Entry;   // time plus bound, state
+  struct Tables
+  {
+    int torches;                         // no more than there are people
+    std::vector<signed char> slowestOf;  // the slowest in each set
+    std::vector<signed char> fastestOf;  // the fastest in each set
+    std::vector<signed char> sizeOf;     // how many are in each set
+    std::vector<long long> pairedOf;     // every other speed from the slowest
+    std::vector<long long> best;         // the time each state is reached
+    std::vector<unsigned int> parent;    // the state before
+    std::vector<unsigned int> moved;     // the set that crossed or returned
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+  };
+
+  // Best-first search over the states.  Each trip forward takes two people
+  // at most, so the trips still to make take at least every other speed of
+  // the near bank counting from the slowest.  With m people and k torches
+  // on the near bank, F trips forward and R returns, 2F >= m + R and
+  // F <= k + R, so R >= m - 2k returns, each at least the fastest speed,
+  // and the first from the far bank if no torch is here.
+  void search(std::vector<Step>& steps)
+  {
+    int n = roster.size();
+    Tables t;
+    t.torches = std::min(torchTotal, std::max(n, 1));
+    unsigned int full = (1u << n) - 1;
+    t.slowestOf.assign(full + 1, -1);
+    t.fastestOf.assign(full + 1, -1);
+    t.sizeOf.assign(full + 1, 0);
+    t.pairedOf.assign(full + 1, 0);
+    int high = 0;
+    for (unsigned int set=1; set<=full; set++)
+    {
+      if (set == (2u << high))
+      {
+        high++;
+      }
+      unsigned int others = set ^ (1u << high);
+      t.slowestOf[set] = high;
+      t.fastestOf[set] = (set & 1) ? 0 : t.fastestOf[set >> 1] + 1;
+      t.sizeOf[set] = t.sizeOf[others] + 1;
+      t.pairedOf[set] = roster[high].getSpeed()
+                      + ((others == 0) ? 0 : t.pairedOf[others ^ (1u << t.slowestOf[others])]);
+    }
+    unsigned int states = (full + 1) * (t.torches + 1);
+    t.best.assign(states, UNREACHABLE_TIME);
+    t.parent.assign(states, 0);
+    t.moved.assign(states, 0);
+
+    unsigned int start = full * (t.torches + 1) + t.torches;
+    t.best[start] = 0;
+    t.open.push(Entry(bound(t, start), start));
+    while (!t.open.empty())
+    {
+      Entry entry = t.open.top();
+      t.open.pop();
+      unsigned int state = entry.second;
+      unsigned int near = state / (t.torches + 1);
+      int torchesNear = state % (t.torches + 1);
+      long long time = t.best[state];
+      if (entry.first >= totalTime)
+      {
+        return;   // nothing left beats the plan in hand
+      }
+      if (entry.first > time + bound(t, state))
+      {
+        continue; // reached sooner since
+      }
+      if (near == 0)
+      {
+        totalTime = time;
+        std::vector<unsigned int> path;
+        for (unsigned int s=state; s!=start; s=t.parent[s])
+        {
+          path.push_back(s);
+        }
+        steps.clear();
+        for (int k=path.size()-1; k>=0; k--)
+        {
+          unsigned int set = t.moved[path[k]];
+          int slow = t.slowestOf[set];
+          int fast = t.fastestOf[set];
+          bool crossed = (path[k] / (t.torches + 1)) < (t.parent[path[k]] / (t.torches + 1));
+          if (!crossed)
+          {
+            steps.push_back(Step::returning(slow, roster[slow].getSpeed()));
+          }
+          else
+          {
+            steps.push_back(Step::crossing(slow, (fast == slow) ? -1 : fast, roster[slow].getSpeed()));
+          }
+        }
+        return;
+      }
+
+      if (torchesNear > 0)
+      {
+        // One or two people on the near bank cross with a torch
+        for (int i=0; i<n; i++)
+        {
+          if ((near & (1u << i)) == 0)
+          {
+            continue;
+          }
+          for (int j=i; j<n; j++)
+          {
+            unsigned int set = (1u << i) | (1u << j);
+            if ((near & set) == set)
+            {
+              unsigned int next = (near ^ set) * (t.torches + 1) + torchesNear - 1;
+              relax(t, state, next, set, time + roster[j].getSpeed());
+            }
+          }
+        }
+      }
+      if (torchesNear < t.torches)
+      {
+        // One person across brings a torch back
+        unsigned int far = full & ~near;
+        for (int i=0; i<n; i++)
+        {
+          if (far & (1u << i))
+          {
+            unsigned int next = (near | (1u << i)) * (t.torches + 1) + torchesNear + 1;
+            relax(t, state, next, 1u << i, time + roster[i].getSpeed());
+          }
+        }
+      }
+    }
+  } // end TorchPlan::search()
+
+  long long bound(const Tables& t, unsigned int state) const
+  {
+    unsigned int near = state / (t.torches + 1);
+    if (near == 0)
+    {
+      return 0;
+    }
+    long long time = t.pairedOf[near];
+    int torchesNear = state % (t.torches + 1);
+    long long returns = std::max(0, t.sizeOf[near] - 2 * torchesNear);
+    if (torchesNear == 0)
+    {
+      unsigned int far = ((1u << roster.size()) - 1) & ~near;
+      time += roster[t.fastestOf[far]].getSpeed() - roster[0].getSpeed();
+    }
+    return time + returns * roster[0].getSpeed();
+  }
+
+  // Reach next from state by moving set, if that is sooner and can still
+  // beat the plan in hand
+  void relax(Tables& t, unsigned int state, unsigned int next, unsigned int set, long long time) const
+  {
+    long long estimate = time + bound(t, next);
+    if (time < t.best[next] && estimate < totalTime)
+    {
+      t.best[next] = time;
+      t.parent[next] = state;
+      t.moved[next] = set;
+      t.open.push(Entry(estimate, next));
+    }
+  }
+
+  // Name the torch each step takes: a trip forward takes the lowest
+  // numbered torch on the near bank, and whoever returns brings back the
+  // torch that came across last
+  void takeTorches(const std::vector<Step>& steps)
+  {
+    std::vector<int> near;
+    std::vector<int> far;
+    for (int k=torchTotal-1; k>=0; k--)
+    {
+      near.push_back(k);
+    }
+    planSteps.clear();
+    for (int k=0; k<steps.size(); k++)
+    {
+      std::vector<int>& from = (steps[k].kind == Step::CROSS) ? near : far;
+      std::vector<int>& to = (steps[k].kind == Step::CROSS) ? far : near;
+      TorchStep s;
+      s.step = steps[k];
+      s.torch = from.back();
+      from.pop_back();
+      to.push_back(s.torch);
+      planSteps.push_back(s);
+    }
+  } // end TorchPlan::takeTorches()
+
+  std::vector<Person> roster;
+  int torchTotal;
+  std::vector<TorchStep> planSteps;
+  long long totalTime;
+  bool exact;
+};  // end class TorchPlan
+
+
+// The Bridge class contains member functions to:
+// - read the yaml file into a private vector of people
+// - the Naive method to compute the shortest crossing time
+// - the Shielding method to compute the shortest crossing time
+// - add people one at a time, keeping a running optimal total
+// There is a private vector of waiting people, and one of people who start
+// on the far bank.  Every method but planConstrained() plans for the waiting
+// people alone, and ignores who can't return.
+class Bridge
+{
+public:
+  Bridge() : waitingPeople(), acrossPeople(), arrivals()
+  {
+  }
+
+  // Add one person who has just arrived, and return the optimal total for
+  // everyone who has arrived so far.  The speeds are kept in an ArrivalTree,
+  // so each arrival costs O(log N).
+  long long arrive(const Person& p)
+  {
+    waitingPeople.push_back(p);
+    arrivals.insert(p.getSpeed());
+    return arrivals.optimalTotal();
+  } // end Bridge::arrive()
+
+  const std::vector<Person>& people() const
+  {
+    return waitingPeople;
+  }
+
+  // The people who start on the far bank (bank: far)
+  const std::vector<Person>& across() const
+  {
+    return acrossPeople;
+  }
+
+  // Parse the yaml, put the resulting people into the waiting people vector
+  // Isolate the file operations and yaml parsing in one function
+  // Reading is silent; writePeopleList() prints the people if wanted.
+  void readPeopleFile(std::string filename)
+  {
+    // The format of the yaml file is:
+    // people:
+    //   - name: A
+    //     speed: 1
+    //   - name: B
+    //     speed: 2
+    //     bank: far
+    //   - name: C
+    //     speed: 5
+    //     can_return: false
+    //     weight: 80
+    // bank is optional; people with "bank: far" start already across.
+    // can_return is optional; people with "can_return: false" never bring
+    // the torch back.  weight is optional, 0 if absent, and only matters
+    // with --max-load.
+
+    // Use the yaml-cpp C++ parser to parse the yaml file into a Node.
+    PhaseTimer timer("load");
+    YAML::Node peopleYAML = YAML::LoadFile(filename);
+
+    struct stat info;
+    if (stat(filename.c_str(), &info) == 0)
+    {
+      Stats::global().addBytesRead(info.st_size);
+    }
+
+    // Look the sequence up once, not once per person
+    YAML::Node people = peopleYAML["people"];
+    waitingPeople.reserve(waitingPeople.size() + people.size());
+    for (int i=0; i<people.size(); i++)
+    {
+      // Add each person to the vector
+      // Scalar() refers to the parsed text, so the name is copied only once,
+      // into the NamePool
+      const std::string& name = people[i]["name"].Scalar();
+      Person p;
+      p.setName( name.data(), name.size() );
+      p.setSpeed( people[i]["speed"].as<int>() );
+      YAML::Node weight = people[i]["weight"];
+      if (weight)
+      {
+        p.setWeight( weight.as<int>() );
+      }
+      YAML::Node canReturn = people[i]["can_return"];
+      if (canReturn)
+      {
+        p.setCanReturn( canReturn.as<bool>() );
+      }
+      YAML::Node bank = people[i]["bank"];
+      if (bank && bank.Scalar() == "far")
+      {
+        acrossPeople.push_back(p);
+      }
+      else
+      {
+        waitingPeople.emplace_back(p);
+      }
+    }
+
+    if (DEBUG==1) {std::cout << "people:" << std::endl << people << std::endl;}
+
+  } // end Bridge::readPeopleFile()
+
+
+  // Read a line-oriented roster dump into the waiting people vector.
+  // The format of the dump is one person per line, name then speed:
+  //   A 1
+  //   B 2
+  // Blank lines and lines starting with # are skipped.
+  //
+  // The file is mapped into memory and cut into one chunk per thread, each
+  // ending at a newline.  The threads parse their chunks into their own
+  // vectors of records, pointing at the names inside the mapping, and the
+  // vectors are then appended to waitingPeople in order.  Names are interned
+  // during that last step, on this thread, since the NamePool is shared.
+  // Returns false (with a message) on an unreadable file or a bad line.
+  bool readPeopleDump(std::string filename, int threads)
+  {
+    PhaseTimer timer("load");
+    return parsePeopleDump(filename, threads);
+  } // end Bridge::readPeopleDump()
+
+
+  // Read a CSV or TSV roster, as exported by HR, into the waiting people
+  // vector.  The first record is a header naming the columns; the columns
+  // "name" and "speed" are used, in any position, and others are ignored:
+  //   id,name,speed
+  //   17,"Smith, A",1
+  // The file is tab separated if the header contains a tab.
+  // Returns false (with a message) on an unreadable file or a bad record.
+  bool readPeopleCsv(std::string filename)
+  {
+    PhaseTimer timer("load");
+    return parsePeopleCsv(filename);
+  } // end Bridge::readPeopleCsv()
+
+
+  // The index of the fastest person, the first one if several tie, or -1
+  // if there are no people.  The Naive Method pairs everyone with them.
+  int fastestIndex() const
+  {
+    int fastest = -1;
+    for (int i=0; i<waitingPeople.size(); i++)
+    {
+      if (fastest < 0 || waitingPeople[i].getSpeed() < waitingPeople[fastest].getSpeed())
+      {
+        fastest = i;
+      }
+    }
+    return fastest;
+  } // end Bridge::fastestIndex()
+
+
+  // Compute the optimal total without printing or reordering the people.
+  // Small rosters go to the unrolled solveSmall<N>(); larger rosters sort a
+  // copy of the speeds and run the same rounds in a loop.
+  long long optimalTotal() const
+  {
+    if (waitingPeople.size() <= SMALL_ROSTER_MAX)
+    {
+      return SmallDispatch<SMALL_ROSTER_MAX>::solve(waitingPeople);
+    }
+
+    std::vector<int> speeds;
+    speeds.reserve(waitingPeople.size());
+    for (int i=0; i<waitingPeople.size(); i++)
+    {
+      speeds.push_back(waitingPeople[i].getSpeed());
+    }
+    std::sort( speeds.begin(), speeds.end() );
+
+    long long totalSpeed = 0;
+    int n = speeds.size();
+    while (n >= 4)
+    {
+      totalSpeed += roundTime<long long>(speeds[0], speeds[1], speeds[n-1], speeds[n-2]);
+      n -= 2;
+    }
+
+    // Only 2 or 3 people can be left here
+    return totalSpeed + finalTime<long long>(n, speeds[0], speeds[1], n == 3 ? speeds[2] : 0);
+  } // end Bridge::optimalTotal()
+
+
+  // Given a vector of people, compute the optimal minimum speed
+  // for them all to cross the bridge, and the decisions that achieve it.
+  // This implements the Shielding Method.
+  // The people are sorted in place; the Schedule refers to them, so it is
+  // only valid until the people change.
+  Schedule planOptimally()
+  {
+    // Sort the people, fastest to slowest
+    {
+      PhaseTimer timer("sort");
+      std::sort( waitingPeople.begin(), waitingPeople.end() );
+    }
+
+    PhaseTimer timer("optimal");
+    return Schedule::optimal(waitingPeople);
+  } // end Bridge::planOptimally()
+
+
+  // Split the people across several bridges, each with its own torch, to
+  // minimize the makespan (see Partition).  The people are sorted in place;
+  // the Partition refers to them by index.
+  Partition planBridges(int bridges)
+  {
+    {
+      PhaseTimer timer("sort");
+      std::sort( waitingPeople.begin(), waitingPeople.end() );
+    }
+
+    PhaseTimer timer("bridges");
+    std::vector<int> speeds;
+    speeds.reserve(waitingPeople.size());
+    for (int i=0; i<waitingPeople.size(); i++)
+    {
+      speeds.push_back(waitingPeople[i].getSpeed());
+    }
+    return Partition(speeds, bridges);
+  } // end Bridge::planBridges()
+
+
+  // Plan the crossings of the waiting people with the help of the people
+  // already across, keeping those who can't return from returning (see
+  // ConstrainedPlan)
+  ConstrainedPlan planConstrained(std::size_t tableBytes) const
+  {
+    PhaseTimer timer("constrained");
+    return ConstrainedPlan(waitingPeople, acrossPeople, tableBytes);
+  } // end Bridge::planConstrained()
+
+
+  // Whether the Shielding Method's assumptions fail: someone starts across
+  // or can't return
+  bool isConstrained() const
+  {
+    if (!acrossPeople.empty())
+    {
+      return true;
+    }
+    for (int i=0; i<waitingPeople.size(); i++)
+    {
+      if (!waitingPeople[i].canReturn())
+      {
+        return true;
+      }
+    }
+    return false;
+  } // end Bridge::isConstrained()
+
+
+  // Plan the crossings of the waiting people on a bridge that holds any
+  // number of people up to a total weight (see LoadPlan)
+  LoadPlan planLoad(long long maxLoad) const
+  {
+    PhaseTimer timer("max-load");
+    return LoadPlan(waitingPeople, maxLoad);
+  } // end Bridge::planLoad()
+
+
+  // Plan the crossings of the waiting people with several torches, where a
+  // trip only needs a torch on its own side (see TorchPlan)
+  TorchPlan planTorches(int torches) const
+  {
+    PhaseTimer timer("torches");
+    return TorchPlan(waitingPeople, torches);
+  } // end Bridge::planTorches()
+
+
+  // The Naive Method's total, without printing: everyone but the fastest
+  // person crosses with them, and they return after every crossing but the
+  // last.
+  long long naiveTotal() const
+  {
+    PhaseTimer timer("naive");
+    if (waitingPeople.size() <= 1)
+    {
+      return waitingPeople.empty() ? 0 : waitingPeople[0].getSpeed();
+    }
+
+    long long fastest = std::numeric_limits<int>::max();
+    long long sum = 0;
+    for (int i=0; i<waitingPeople.size(); i++)
+    {
+      fastest = std::min<long long>(fastest, waitingPeople[i].getSpeed());
+      sum += waitingPeople[i].getSpeed();
+    }
+    return (sum - fastest) + (waitingPeople.size() - 2) * fastest;
+  } // end Bridge::naiveTotal()
+
+private:
+  // The work of readPeopleDump()
+  bool parsePeopleDump(std::string filename, int threads)
+  {
+    MappedFile file;
+    if (!file.open(filename))
+    {
+      return false;
+    }
+
+    if (threads <= 0)
+    {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (file.size() < PARALLEL_PARSE_MIN_BYTES)
+    {
+      threads = 1;
+    }
+
+    // Cut the file at the first newline after each even split point
+    std::vector<const char *> cuts;
+    cuts.push_back(file.begin());
+    for (int t=1; t<threads; t++)
+    {
+      const char * cut = file.begin() + file.size() / threads * t;
+      if (cut < cuts.back())
+      {
+        cut = cuts.back();
+      }
+      cut = static_cast<const char *>(std::memchr(cut, '\n', file.end() - cut));
+      cut = (cut == nullptr) ? file.end() : cut + 1;
+      cuts.push_back(cut);
+    }
+    cuts.push_back(file.end());
+
+    std::vector< std::vector<DumpRecord> > chunks(threads);
+    std::vector<const char *> errors(threads, nullptr);
+    std::vector<std::thread> workers;
+    for (int t=1; t<threads; t++)
+    {
+      workers.emplace_back( [&chunks, &errors, &cuts, t]()
+      {
+        errors[t] = parseDumpLines(cuts[t], cuts[t+1], chunks[t]);
+      } );
+    }
+    errors[0] = parseDumpLines(cuts[0], cuts[1], chunks[0]);
+    for (int t=0; t<workers.size(); t++)
+    {
+      workers[t].join();
+    }
+
+    // Report the first bad line in the file, if any
+    for (int t=0; t<threads; t++)
+    {
+      if (errors[t] != nullptr)
+      {
+        const char * lineEnd = static_cast<const char *>(std::memchr(errors[t], '\n', file.end() - errors[t]));
+        if (lineEnd == nullptr)
+        {
+          lineEnd = file.end();
+        }
+        int line = 1 + std::count(file.begin(), errors[t], '\n');
+        std::cout << "Error: " << filename << " line " << line << ": expected a name and a positive speed, found \""
+                  << std::string(errors[t], lineEnd) << "\"" << std::endl;
+        return false;
+      }
+    }
+
+    std::size_t total = waitingPeople.size();
+    for (int t=0; t<threads; t++)
+    {
+      total += chunks[t].size();
+    }
+    waitingPeople.reserve(total);
+
+    for (int t=0; t<threads; t++)
+    {
+      for (int i=0; i<chunks[t].size(); i++)
+      {
+        Person p;
+        p.setName( chunks[t][i].name, chunks[t][i].nameLength );
+        p.setSpeed( chunks[t][i].speed );
+        waitingPeople.emplace_back(p);
+      }
+    }
+    return true;
+  } // end Bridge::parsePeopleDump()
+
+
+  // The work of readPeopleCsv().
+  // Fields are sliced in place from the mapped file and the field vector is
+  // reused, so the scan allocates nothing per record; only the names that
+  // contain escaped quotes are unescaped, into a reused buffer.
+  bool parsePeopleCsv(std::string filename)
+  {
+    MappedFile file;
+    if (!file.open(filename))
+    {
+      return false;
+    }
+
+    // Spreadsheets often start their exports with a UTF-8 byte order mark
+    const char * begin = file.begin();
+    if (file.size() >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+    {
+      begin += 3;
+    }
+    if (begin == file.end())
+    {
+      std::cout << "Error: " << filename << ": the header is missing" << std::endl;
+      return false;
+    }
+
+    const char * headerEnd = static_cast<const char *>(std::memchr(begin, '\n', file.end() - begin));
+    if (headerEnd == nullptr)
+    {
+      headerEnd = file.end();
+    }
+    char delimiter = (std::memchr(begin, '\t', headerEnd - begin) != nullptr) ? '\t' : ',';
+
+    // Find the name and speed columns in the header
+    std::vector<CsvField> fields;
+    const char * pos = scanCsvRecord(begin, file.end(), delimiter, fields);
+    if (pos == nullptr)
+    {
+      std::cout << "Error: " << filename << " line 1: unterminated quote in the header" << std::endl;
+      return false;
+    }
+    int nameColumn = -1;
+    int speedColumn = -1;
+    for (int i=0; i<fields.size(); i++)
+    {
+      std::string column(fields[i].begin, fields[i].end);
+      std::transform(column.begin(), column.end(), column.begin(), ::tolower);
+      if (column == "name")
+      {
+        nameColumn = i;
+      }
+      else if (column == "speed")
+      {
+        speedColumn = i;
+      }
+    }
+    if (nameColumn < 0 || speedColumn < 0)
+    {
+      std::cout << "Error: " << filename << ": the header must have name and speed columns" << std::endl;
+      return false;
+    }
+    int needed = std::max(nameColumn, speedColumn) + 1;
+
+    std::string unescaped;
+    int record = 1;
+    while (pos < file.end())
+    {
+      const char * start = pos;
+      pos = scanCsvRecord(pos, file.end(), delimiter, fields);
+      record++;
+      if (pos == nullptr)
+      {
+        // Quoted fields may span lines, so count them up to the record
+        std::cout << "Error: " << filename << " line " << 1 + std::count(file.begin(), start, '\n')
+                  << ": unterminated quote in record " << record << std::endl;
+        return false;
+      }
+
+      // Skip blank lines
+      if (fields.size() == 1 && fields[0].begin == fields[0].end)
+      {
+        continue;
+      }
+
+      int speed;
+      if (fields.size() < needed ||
+          !parseSpeed(fields[speedColumn].begin, fields[speedColumn].end, speed))
+      {
+        std::cout << "Error: " << filename << " record " << record << ": expected a name and a positive speed" << std::endl;
+        return false;
+      }
+
+      Person p;
+      p.setSpeed(speed);
+
+      const CsvField& name = fields[nameColumn];
+      if (name.escaped)
+      {
+        unescaped.clear();
+        for (const char * c=name.begin; c<name.end; c++)
+        {
+          unescaped.push_back(*c);
+          if (*c == '"')
+          {
+            c++; // skip the second quote of the pair
+          }
+        }
+        p.setName( unescaped.data(), unescaped.size() );
+      }
+      else
+      {
+        p.setName( name.begin, name.end - name.begin );
+      }
+      waitingPeople.emplace_back(p);
+    }
+    return true;
+  } // end Bridge::parsePeopleCsv()
+
+
+  // Pick the solveSmall<N>() instantiation matching the number of people,
+  // counting down from the largest supported size.
+  template <int N, bool Done = (N == 0)>
+  struct SmallDispatch
+  {
+    static long long solve(const std::vector<Person>& people)
+    {
+      if (people.size() != N)
+      {
+        return SmallDispatch<N-1>::solve(people);
+      }
+      std::array<int, N> speeds;
+      for (int i=0; i<N; i++)
+      {
+        speeds[i] = people[i].getSpeed();
+      }
+      return solveSmall<N>(speeds);
+    }
+  };
+
+  template <int N>
+  struct SmallDispatch<N, true>
+  {
+    static long long solve(const std::vector<Person>&)
+    {
+      return 0;
+    }
+  };
+
+  std::vector<Person> waitingPeople;
+  std::vector<Person> acrossPeople; // already on the far bank
+  ArrivalTree arrivals; // speeds of the people added by arrive()
+
+}; // end class Bridge
+
+
+// --------------------------------------------------------------------------
+//                             Functions
+// --------------------------------------------------------------------------
+
+// Count every heap allocation for --stats.  The counters are shared by all
+// threads, so without --stats they are left alone, and the threads of the
+// dump parser and the parallel search don't contend for their cache line.
+// Like operator delete below, it is kept out of line: at -O3 the compiler
+// would otherwise see malloc() paired with operator delete, and warn.
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void * operator new(std::size_t size)
+{
+  if (countingAllocations)
+  {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  void * p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+// Kept out of line: if the compiler inlines it next to a call to the
+// replaced operator new, it warns about free() of new'd memory
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void * p) noexcept
+{
+  std::free(p);
+}
+
+// The sized form C++14 calls when the size is known
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void * p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+
+// Parse a positive decimal integer that fills [begin, end) exactly.
+// Hand-written because C++11 has no std::from_chars, and the stream and
+// strtol alternatives need a copy or a terminator.
+bool parseSpeed(const char * begin, const char * end, int& speed)
+{
+  if (begin == end)
+  {
+    return false;
+  }
+
+  long long value = 0;
+  for (const char * c=begin; c<end; c++)
+  {
+    if (*c < '0' || *c > '9')
+    {
+      return false;
+    }
+    value = value * 10 + (*c - '0');
+    if (value > std::numeric_limits<int>::max())
+    {
+      return false;
+    }
+  }
+  if (value == 0)
+  {
+    return false;
+  }
+
+  speed = static_cast<int>(value);
+  return true;
+} // end parseSpeed()
+
+
+// Scan one CSV record starting at pos, replacing the contents of fields with
+// slices of the buffer (RFC 4180 quoting, quoted fields may span lines).
+// Spaces around unquoted fields are trimmed.
+// Returns the start of the next record, or nullptr if a quote is unclosed.
+const char * scanCsvRecord(const char * pos, const char * end, char delimiter,
+                           std::vector<CsvField>& fields)
+{
+  fields.clear();
+  while (true)
+  {
+    CsvField field;
+    field.escaped = false;
+
+    while (pos < end && *pos == ' ')
+    {
+      pos++;
+    }
+
+    if (pos < end && *pos == '"')
+    {
+      // Quoted field: runs to the next quote that isn't doubled
+      pos++;
+      field.begin = pos;
+      while (true)
+      {
+        pos = static_cast<const char *>(std::memchr(pos, '"', end - pos));
+        if (pos == nullptr)
+        {
+          return nullptr;
+        }
+        if (pos + 1 < end && pos[1] == '"')
+        {
+          field.escaped = true;
+          pos += 2;
+          continue;
+        }
+        break;
+      }
+      field.end = pos;
+      pos++;
+      // Ignore anything between the closing quote and the delimiter
+      while (pos < end && *pos != delimiter && *pos != '\n')
+      {
+        pos++;
+      }
+    }
+    else
+    {
+      field.begin = pos;
+      while (pos < end && *pos != delimiter && *pos != '\n')
+      {
+        pos++;
+      }
+      field.end = pos;
+      while (field.end > field.begin && (field.end[-1] == ' ' || field.end[-1] == '\r'))
+      {
+        field.end--;
+      }
+    }
+    fields.push_back(field);
+
+    if (pos >= end)
+    {
+      return end;
+    }
+    if (*pos == '\n')
+    {
+      return pos + 1;
+    }
+    pos++; // past the delimiter
+  }
+} // end scanCsvRecord()
+
+
+// Parse one line of a roster dump, [line, lineEnd) without the newline.
+// Sets blank (and leaves record alone) for blank and comment lines.
+// Returns false if the line isn't a name followed by a positive speed.
+bool parseDumpLine(const char * line, const char * lineEnd, DumpRecord& record, bool& blank)
+{
+  // Trim spaces, tabs and a Windows carriage return
+  const char * first = line;
+  const char * last = lineEnd;
+  while (first < last && (*first == ' ' || *first == '\t'))
+  {
+    first++;
+  }
+  while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+  {
+    last--;
+  }
+
+  blank = (first == last || *first == '#');
+  if (blank)
+  {
+    return true;
+  }
+
+  // The name runs to the first blank, the speed is the last field
+  const char * nameEnd = first;
+  while (nameEnd < last && *nameEnd != ' ' && *nameEnd != '\t')
+  {
+    nameEnd++;
+  }
+  const char * speedBegin = nameEnd;
+  while (speedBegin < last && (*speedBegin == ' ' || *speedBegin == '\t'))
+  {
+    speedBegin++;
+  }
+
+  record.name = first;
+  record.nameLength = nameEnd - first;
+  return parseSpeed(speedBegin, last, record.speed);
+} // end parseDumpLine()
+
+
+// Parse the lines of a roster dump in [begin, end), appending one record per
+// person.  The names are left in the buffer, so nothing is copied.
+// Returns nullptr on success, or the start of the first bad line.
+const char * parseDumpLines(const char * begin, const char * end,
+                            std::vector<DumpRecord>& records)
+{
+  const char * line = begin;
+  while (line < end)
+  {
+    const char * lineEnd = static_cast<const char *>(std::memchr(line, '\n', end - line));
+    if (lineEnd == nullptr)
+    {
+      lineEnd = end;
+    }
+
+    DumpRecord record;
+    bool blank;
+    if (!parseDumpLine(line, lineEnd, record, blank))
+    {
+      return line;
+    }
+    if (!blank)
+    {
+      records.push_back(record);
+    }
+
+    line = lineEnd + 1;
+  }
+  return nullptr;
+} // end parseDumpLines()
+
+
+// Read the people named on the command line into the bridge, from a YAML
+// file, a roster dump or a CSV file.  Returns false if reading failed (the
+// reader has printed why).
+bool loadPeople(const Arguments& args, Bridge& bridge)
+{
+  if (args.dumpFilename != "")
+  {
+    return bridge.readPeopleDump(args.dumpFilename, args.threads);
+  }
+  if (args.csvFilename != "")
+  {
+    return bridge.readPeopleCsv(args.csvFilename);
+  }
+  bridge.readPeopleFile(args.peopleFilename);
+  return true;
+} // end loadPeople()
+
+
+// Write the people, in the order they were read, for --list-people:
+//   Person 0 -  Name: A  Speed: 1
+void writePeopleList(BufferedWriter& out, const std::vector<Person>& people)
+{
+  PhaseTimer timer("list");
+  out.put('\n');
+  if (people.size() > 0)
+  {
+    out.write("List of all people:\n");
+  }
+  else
+  {
+    out.write("No people found in input file\n");
+  }
+  for (int i=0; i<people.size(); i++)
+  {
+    NameRef name = people[i].getNameRef();
+    out.write("Person ");
+    out.write(static_cast<long long>(i));
+    out.write(" -  Name: ");
+    out.write(name.data, name.length);
+    out.write("  Speed: ");
+    out.write(static_cast<long long>(people[i].getSpeed()));
+    out.put('\n');
+  }
+} // end writePeopleList()
+
+
+// Write the Naive Method's crossings: each person in turn crosses with the
+// fastest person, who returns after every crossing but the last.  Nothing
+// is written for fewer than two people.
+void writeNaiveCrossings(BufferedWriter& out, const std::vector<Person>& people, int fastest)
+{
+  PhaseTimer timer("output");
+  if (people.size() <= 1)
+  {
+    return;
+  }
+
+  out.write("\nFastest overall person: ");
+  people[fastest].write(out);
+  out.write("\n\nNaive sequence of bridge crossings:\n");
+  int remaining = people.size() - 1;
+  for (int i=0; i<people.size(); i++)
+  {
+    if (i == fastest)
+    {
+      continue;
+    }
+    people[i].write(out);
+    out.write(" and ");
+    people[fastest].write(out);
+    out.write(" cross\n");
+    remaining--;
+    if (remaining > 0)
+    {
+      people[fastest].write(out);
+      out.write(" returns\n");
+    }
+  }
+} // end writeNaiveCrossings()
+
+
+// Write the crossings of a Shielding Method schedule, one step per line
+void writeOptimalCrossings(BufferedWriter& out, const Schedule& schedule)
+{
+  PhaseTimer timer("output");
+  out.write("\nOptimal sequence of bridge crossings:\n");
+  for (Schedule::Iterator it = schedule.begin(); it != schedule.end(); ++it)
+  {
+    (*it).write(out, schedule.people());
+    out.put('\n');
+  }
+} // end writeOptimalCrossings()
+
+
+// Write the people who start across or can't return, and the crossings
+// planned for them
+void writeConstrainedCrossings(BufferedWriter& out, const ConstrainedPlan& plan,
+                               const std::vector<Person>& across)
+{
+  PhaseTimer timer("output");
+  if (!across.empty())
+  {
+    out.write("\nPeople already across:");
+    for (int i=0; i<across.size(); i++)
+    {
+      out.put(' ');
+      across[i].write(out);
+    }
+    out.put('\n');
+  }
+  bool anyStaying = false;
+  for (int i=0; i<plan.people().size(); i++)
+  {
+    if (!plan.people()[i].canReturn())
+    {
+      if (!anyStaying)
+      {
+        out.write("\nPeople who can't return:");
+        anyStaying = true;
+      }
+      out.put(' ');
+      plan.people()[i].write(out);
+    }
+  }
+  if (anyStaying)
+  {
+    out.put('\n');
+  }
+  if (!plan.isFeasible())
+  {
+    out.write("\nNo schedule gets everyone across: nobody can bring the torch back\n");
+    return;
+  }
+  if (!plan.isFound())
+  {
+    out.write("\nThe constrained crossings need an exact search, but there are too many speeds\n");
+    return;
+  }
+
+  out.write("\nSequence of constrained bridge crossings:\n");
+  for (int k=0; k<plan.steps().size(); k++)
+  {
+    plan.steps()[k].write(out, plan.people());
+    out.put('\n');
+  }
+  out.write("\nThe fastest constrained total time is: ");
+  out.write(plan.total());
+  if (plan.isSearched())
+  {
+    out.write(" (exact search, ");
+    out.write(plan.statesExpanded());
+    out.write(" states searched)\n");
+  }
+  else
+  {
+    out.write(" (optimal)\n");
+  }
+} // end writeConstrainedCrossings()
+
+
+// Write the crossings planned for a bridge rated by load
+void writeLoadCrossings(BufferedWriter& out, const LoadPlan& plan)
+{
+  PhaseTimer timer("output");
+  if (!plan.isFeasible())
+  {
+    out.write("\nNo schedule gets everyone across under a load of ");
+    out.write(plan.maxLoad());
+    if (plan.overweight() >= 0)
+    {
+      out.write(": ");
+      plan.people()[plan.overweight()].write(out);
+      out.write(" weighs ");
+      out.write(static_cast<long long>(plan.people()[plan.overweight()].getWeight()));
+      out.put('\n');
+    }
+    else
+    {
+      out.write(": no two people can cross together to bring the torch back\n");
+    }
+    return;
+  }
+
+  out.write("\nSequence of bridge crossings under a load of ");
+  out.write(plan.maxLoad());
+  out.write(":\n");
+  for (int k=0; k<plan.steps().size(); k++)
+  {
+    plan.steps()[k].write(out, plan.people());
+    out.put('\n');
+  }
+  out.write("\nThe fastest total time under the load is: ");
+  out.write(plan.total());
+  out.write(plan.isExact() ? " (optimal)\n" : " (best found)\n");
+} // end writeLoadCrossings()
+
+
+// Write which people cross on each bridge, and each bridge's time:
+//   Bridge 0 takes 17: (A,1) (B,2) (C,5) (D,10)
+void writeBridgePartition(BufferedWriter& out, const std::vector<Person>& people,
+                          const Partition& partition)
+{
+  PhaseTimer timer("output");
+  std::vector<std::vector<int> > members(partition.bridges());
+  for (int i=0; i<people.size(); i++)
+  {
+    members[partition.bridgeOf(i)].push_back(i);
+  }
+
+  out.write("\nPeople on each of ");
+  out.write(static_cast<long long>(partition.bridges()));
+  out.write(" bridges:\n");
+  for (int b=0; b<members.size(); b++)
+  {
+    out.write("Bridge ");
+    out.write(static_cast<long long>(b));
+    out.write(" takes ");
+    out.write(partition.bridgeTime(b));
+    out.put(':');
+    for (int k=0; k<members[b].size(); k++)
+    {
+      out.put(' ');
+      people[members[b][k]].write(out);
+    }
+    out.put('\n');
+  }
+
+  out.write("\nThe fastest makespan across ");
+  out.write(static_cast<long long>(partition.bridges()));
+  out.write(" bridges is: ");
+  out.write(partition.makespan());
+  out.write(partition.isExact() ? " (exact)\n" : " (heuristic)\n");
+} // end writeBridgePartition()
+
+
+// Write the crossings with several torches, each step with its torch:
+//   Torch 0: (D,10) and (C,5) cross
+void writeTorchCrossings(BufferedWriter& out, const TorchPlan& plan)
+{
+  PhaseTimer timer("output");
+  out.write("\nSequence of bridge crossings with ");
+  out.write(static_cast<long long>(plan.torches()));
+  out.write(" torches:\n");
+  for (int k=0; k<plan.steps().size(); k++)
+  {
+    out.write("Torch ");
+    out.write(static_cast<long long>(plan.steps()[k].torch));
+    out.write(": ");
+    plan.steps()[k].step.write(out, plan.people());
+    out.put('\n');
+  }
+  out.write("\nThe fastest total time with ");
+  out.write(static_cast<long long>(plan.torches()));
+  out.write(" torches is: ");
+  out.write(plan.total());
+  out.write(plan.isExact() ? " (optimal one trip at a time)\n" : " (best found)\n");
+} // end writeTorchCrossings()
+
+
+// Why a roster has too many crossing states for --exact, or "" if it has
+// few enough
+std::string exactSearchLimit(const Arguments& args, const CrossingStates& states)
+{
+  unsigned long long most = EXACT_SEARCH_STATES;
+  if (args.exact == "parallel")
+  {
+    most = PARALLEL_SEARCH_STATES;
+  }
+  else if (args.exact == "ida")
+  {
+    // Memory doesn't grow with the states
+    most = std::numeric_limits<unsigned long long>::max();
+  }
+  std::ostringstream why;
+  if (states.count() == std::numeric_limits<unsigned long long>::max())
+  {
+    why << "--exact " << args.exact << " can't number the states of these "
+        << states.size() << " people";
+  }
+  else if (states.count() > most)
+  {
+    why << "--exact " << args.exact << " searches at most " << most
+        << " states, too few for these " << states.size() << " people";
+  }
+  return why.str();
+} // end exactSearchLimit()
+
+
+// Whether a roster has few enough crossing states for --exact; says so if
+// not
+bool exactSearchFits(const Arguments& args, const CrossingStates& states)
+{
+  std::string why = exactSearchLimit(args, states);
+  if (why != "")
+  {
+    std::cout << "Error: " << why << std::endl;
+    return false;
+  }
+  return true;
+} // end exactSearchFits()
+
+
+bool exactSearchFits(const Arguments& args, const Schedule& schedule)
+{
+  return exactSearchFits(args, CrossingStates(CrossingSearch::speedsOf(schedule)));
+}
+
+
+// Write whether everyone can cross before the torch burns out.  The
+// Shielding Method's total is optimal, so this needs no search.
+void writeTorchLimit(BufferedWriter& out, long long limit, long long optimal)
+{
+  PhaseTimer timer("output");
+  out.write("\nThe torch lasts ");
+  out.write(limit);
+  if (optimal <= limit)
+  {
+    out.write(" minutes: crossing is feasible, with ");
+    out.write(limit - optimal);
+    out.write(" minutes to spare\n");
+  }
+  else
+  {
+    out.write(" minutes: crossing is not feasible, it takes at least ");
+    out.write(optimal);
+    out.write(" minutes\n");
+  }
+} // end writeTorchLimit()
+
+
+// The outcome of --exact, from whichever search ran
+struct ExactResult
+{
+  long long total;
+  std::vector<Step> steps; // people are indexes into the sorted roster
+  long long statesExpanded;
+  bool improved;           // shorter than the Shielding Method
+};
+
+
+// Run the exact search --exact names, seeded with the Shielding Method's
+// schedule.  "parallel" uses --threads workers, or one per core, and "ida"
+// a transposition table of --tt-size MiB.
+ExactResult searchExactly(const Arguments& args, const Schedule& schedule)
+{
+  PhaseTimer timer("exact");
+  ExactResult result;
+  if (args.exact == "parallel")
+  {
+    int threads = args.threads;
+    if (threads <= 0)
+    {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ParallelCrossingSearch search(schedule, threads);
+    result.improved = search.run();
+    result.total = search.total();
+    result.steps = search.steps();
+    result.statesExpanded = search.statesExpanded();
+  }
+  else if (args.exact == "ida")
+  {
+    IdaCrossingSearch search(schedule, args.ttSize << 20);
+    result.improved = search.run();
+    result.total = search.total();
+    result.steps = search.steps();
+    result.statesExpanded = search.statesExpanded();
+  }
+  else
+  {
+    CrossingSearch search(schedule);
+    result.improved = search.run();
+    result.total = search.total();
+    result.steps = search.steps();
+    result.statesExpanded = search.statesExpanded();
+  }
+  return result;
+} // end searchExactly()
+
+
+// The same, over a given space from an incumbent schedule for it.
+// improved means shorter than the incumbent.
+ExactResult searchStates(const Arguments& args, const CrossingStates& states,
+                         const std::vector<Step>& incumbent)
+{
+  PhaseTimer timer("exact");
+  ExactResult result;
+  if (args.exact == "parallel")
+  {
+    int threads = args.threads;
+    if (threads <= 0)
+    {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ParallelCrossingSearch search(states, incumbent, threads);
+    result.improved = search.run();
+    result.total = search.total();
+    result.steps = search.steps();
+    result.statesExpanded = search.statesExpanded();
+  }
+  else if (args.exact == "ida")
+  {
+    IdaCrossingSearch search(states, incumbent, args.ttSize << 20);
+    result.improved = search.run();
+    result.total = search.total();
+    result.steps = search.steps();
+    result.statesExpanded = search.statesExpanded();
+  }
+  else
+  {
+    CrossingSearch search(states, incumbent);
+    result.improved = search.run();
+    result.total = search.total();
+    result.steps = search.steps();
+    result.statesExpanded = search.statesExpanded();
+  }
+  return result;
+} // end searchStates()
+
+
+// Write the result of an exact search, and the schedule it found
+void writeExactSearch(BufferedWriter& out, const std::vector<Person>& people,
+                      const ExactResult& result)
+{
+  PhaseTimer timer("output");
+  out.write("\nExact sequence of bridge crossings:\n");
+  for (int k=0; k<result.steps.size(); k++)
+  {
+    result.steps[k].write(out, people);
+    out.put('\n');
+  }
+  out.write("\nThe exact fastest total time is: ");
+  out.write(result.total);
+  out.write(result.improved ? " (shorter than the Shielding Method, " : " (the Shielding Method is optimal, ");
+  out.write(result.statesExpanded);
+  out.write(" states searched)\n");
+} // end writeExactSearch()
+
+
+// The Shielding Method under a pair cost, for speeds sorted fastest to
+// slowest.  The slowest people cross first, each with (0), who returns, or
+// two at a time between the trips of (0) and (1), as in a Shielding round,
+// and the last three or fewer in the best order there is for them.  best[m]
+// is the least time for the first m people, in O(N) for all of them.
+// Unlike the rounds of Bridge::planOptimally(), a run of people may cross
+// with (0) one at a time, so an odd number of them can, which only matters
+// when pairs cost more than the slower person's pace.  Under MaxCost the
+// total is the Shielding Method's.  The steps' people are indexes into the
+// speeds.
+template <typename Cost>
+std::vector<Step> planPairRounds(const std::vector<int>& speeds, const Cost& cost)
+{
+  int n = speeds.size();
+  std::vector<Step> steps;
+  if (n <= 1)
+  {
+    if (n == 1)
+    {
+      steps.push_back(Step::crossing(0, -1, speeds[0]));
+    }
+    return steps;
+  }
+
+  // Three people: any two cross, and either comes back for the third
+  long long three = std::numeric_limits<long long>::max();
+  int threeFirst = 0;
+  int threeSecond = 0;
+  int threeReturner = 0;
+  for (int a=0; a<3 && n>=3; a++)
+  {
+    for (int b=a+1; b<3; b++)
+    {
+      int c = 3 - a - b;
+      for (int returner=a; returner<=b; returner+=b-a)
+      {
+        long long time = cost(speeds[a], speeds[b]) + speeds[returner]
+                         + cost(speeds[std::min(returner, c)], speeds[std::max(returner, c)]);
+        if (time < three)
+        {
+          three = time;
+          threeFirst = a;
+          threeSecond = b;
+          threeReturner = returner;
+        }
+      }
+    }
+  }
+
+  std::vector<long long> best(n + 1, 0);
+  std::vector<bool> shielded(n + 1, false);
+  best[2] = cost(speeds[0], speeds[1]);
+  if (n >= 3)
+  {
+    best[3] = three;
+  }
+  long long shuttles = cost(speeds[0], speeds[1]) + speeds[0] + speeds[1];
+  for (int m=4; m<=n; m++)
+  {
+    long long alone = cost(speeds[0], speeds[m-1]) + speeds[0] + best[m-1];
+    long long paired = shuttles + cost(speeds[m-2], speeds[m-1]) + best[m-2];
+    shielded[m] = (paired < alone);
+    best[m] = std::min(alone, paired);
+  }
+
+  // The steps, slowest people first
+  int m = n;
+  while (m > 3)
+  {
+    if (shielded[m])
+    {
+      steps.push_back(Step::crossing(1, 0, cost(speeds[0], speeds[1])));
+      steps.push_back(Step::returning(0, speeds[0]));
+      steps.push_back(Step::crossing(m - 1, m - 2, cost(speeds[m-2], speeds[m-1])));
+      steps.push_back(Step::returning(1, speeds[1]));
+      m -= 2;
+    }
+    else
+    {
+      steps.push_back(Step::crossing(m - 1, 0, cost(speeds[0], speeds[m-1])));
+      steps.push_back(Step::returning(0, speeds[0]));
+      m -= 1;
+    }
+  }
+  if (m == 2)
+  {
+    steps.push_back(Step::crossing(1, 0, best[2]));
+  }
+  else
+  {
+    int c = 3 - threeFirst - threeSecond;
+    int slow = std::max(threeReturner, c);
+    int fast = std::min(threeReturner, c);
+    steps.push_back(Step::crossing(threeSecond, threeFirst, cost(speeds[threeFirst], speeds[threeSecond])));
+    steps.push_back(Step::returning(threeReturner, speeds[threeReturner]));
+    steps.push_back(Step::crossing(slow, fast, cost(speeds[fast], speeds[slow])));
+  }
+  return steps;
+} // end planPairRounds()
+
+
+// The crossings under a pair cost: planPairRounds(), then with --exact
+// the chosen search over every schedule, which proves the rounds optimal
+// or finds shorter crossings
+struct PairCostResult
+{
+  long long total;
+  std::vector<Step> steps; // people are indexes into the sorted roster
+  bool searched;           // whether --exact ran
+  bool improved;           // shorter than the rounds
+  long long statesExpanded;
+  std::string exactError;  // why --exact couldn't run, or ""
+};
+
+template <typename Cost>
+PairCostResult planPairCost(const Arguments& args, const std::vector<Person>& sorted, const Cost& cost)
+{
+  PhaseTimer timer("pair-cost");
+  std::vector<int> speeds;
+  for (int i=0; i<sorted.size(); i++)
+  {
+    speeds.push_back(sorted[i].getSpeed());
+  }
+  PairCostResult result;
+  result.steps = planPairRounds(speeds, cost);
+  result.total = CrossingSearch::totalOf(result.steps);
+  result.searched = false;
+  result.improved = false;
+  result.statesExpanded = 0;
+
+  CrossingStates states(speeds);
+  if (args.exact == "" || sorted.empty())
+  {
+    return result;
+  }
+  // The caller reports this, as text or not at all
+  result.exactError = exactSearchLimit(args, states);
+  if (result.exactError != "")
+  {
+    return result;
+  }
+  states.setPairCost(cost);
+  ExactResult exact = searchStates(args, states, result.steps);
+  result.total = exact.total;
+  result.steps = exact.steps;
+  result.searched = true;
+  result.improved = exact.improved;
+  result.statesExpanded = exact.statesExpanded;
+  return result;
+} // end planPairCost()
+
+
+// Plan under the cost --pair-penalty or --pair-table gives.  Returns false
+// (with a message) if the table can't be used.
+bool solvePairCost(const Arguments& args, const std::vector<Person>& sorted, PairCostResult& result)
+{
+  if (args.pairPenalty >= 0)
+  {
+    result = planPairCost(args, sorted, PenaltyCost(args.pairPenalty));
+    return true;
+  }
+  TableCost table;
+  if (!table.readFile(args.pairTable))
+  {
+    return false;
+  }
+  result = planPairCost(args, sorted, table);
+  return true;
+} // end solvePairCost()
+
+
+// Write the crossings under a pair cost
+void writePairCostCrossings(BufferedWriter& out, const std::vector<Person>& people,
+                            const PairCostResult& result)
+{
+  PhaseTimer timer("output");
+  out.write("\nSequence of bridge crossings with the pair cost:\n");
+  for (int k=0; k<result.steps.size(); k++)
+  {
+    result.steps[k].write(out, people);
+    out.put('\n');
+  }
+  out.write("\nThe fastest total time with the pair cost is: ");
+  out.write(result.total);
+  if (!result.searched)
+  {
+    out.write(" (best of the rounds)\n");
+    return;
+  }
+  out.write(result.improved ? " (shorter than the rounds, " : " (the rounds are optimal, ");
+  out.write(result.statesExpanded);
+  out.write(" states searched)\n");
+} // end writePairCostCrossings()
+
+
+// The number of distinct optimal schedules of the form the Shielding
+// Method plans: each round sends the two slowest people left across, by
+// the Shielding or the Naive Method.  They differ in the rounds where both
+// methods take the same time, and in which of the people of equal speed
+// takes each part.  Walking the roster slowest first, the k-th person of
+// a speed met can take the part of any of the k, so the people of equal
+// speed contribute size! orderings in all.  Two people of equal speed who
+// cross together, in a Shielding round or as the whole roster, give the
+// same schedule either way round, which halves their orderings.  One
+// pass; the count is exact however large.
+BigNatural countOptimalSchedules(const Schedule& schedule)
+{
+  PhaseTimer timer("count");
+  const std::vector<Person>& people = schedule.people();
+  int n = people.size();
+
+  // How many people of each one's speed are at their place or slower
+  std::vector<unsigned int> rank(n);
+  for (int i=n-1; i>=0; i--)
+  {
+    bool tied = (i < n - 1 && people[i].getSpeed() == people[i+1].getSpeed());
+    rank[i] = tied ? rank[i+1] + 1 : 1;
+  }
+
+  BigNatural count(1);
+  for (int round=0; round<schedule.rounds(); round++)
+  {
+    int slowest = n - 1 - 2 * round;
+    long long shielding = shieldingRoundTime<long long>(people[0].getSpeed(), people[1].getSpeed(),
+                                                        people[slowest].getSpeed());
+    long long naive = naiveRoundTime<long long>(people[0].getSpeed(), people[slowest].getSpeed(),
+                                                people[slowest-1].getSpeed());
+    unsigned int high = rank[slowest];
+    unsigned int low = rank[slowest-1];
+    bool pairTied = (people[slowest].getSpeed() == people[slowest-1].getSpeed());
+    unsigned int methods = (shielding == naive) ? 2 : 1;
+    if (pairTied && shielding <= naive)
+    {
+      // Crossing together, the pair's orderings count half; one of two
+      // consecutive ranks is even.  Naive still counts them all, twice
+      // what Shielding does.
+      if (high % 2 == 0)
+      {
+        high /= 2;
+      }
+      else
+      {
+        low /= 2;
+      }
+      methods = (shielding == naive) ? 3 : 1;
+    }
+    count.multiply(high);
+    count.multiply(low);
+    count.multiply(methods);
+  }
+
+  // The last one, two or three people; two alone cross together
+  int left = n - 2 * schedule.rounds();
+  bool pairAlone = (n == 2 && people[0].getSpeed() == people[1].getSpeed());
+  for (int i=(pairAlone ? 1 : 0); i<left; i++)
+  {
+    count.multiply(rank[i]);
+  }
+  return count;
+} // end countOptimalSchedules()
+
+
+// The k fastest schedules that make their own round decisions, fastest
+// first; fewer if there aren't k
+std::vector<Schedule> rankSchedules(const Schedule& optimal, int k)
+{
+  PhaseTimer timer("ranked");
+  std::vector<Schedule> ranked;
+  ScheduleRanking ranking(optimal);
+  Schedule schedule(optimal);
+  while (ranked.size() < k && ranking.next(schedule))
+  {
+    ranked.push_back(schedule);
+  }
+  return ranked;
+} // end rankSchedules()
+
+
+// A schedule's round decisions, S for Shielding and N for Naive
+std::string roundDecisions(const Schedule& schedule)
+{
+  std::string decisions;
+  for (int round=0; round<schedule.rounds(); round++)
+  {
+    decisions += schedule.isShielding(round) ? 'S' : 'N';
+  }
+  return decisions;
+} // end roundDecisions()
+
+
+// Write the ranked schedules and their crossings:
+//   Schedule 2 takes 18 (rounds N):
+void writeRankedSchedules(BufferedWriter& out, const std::vector<Schedule>& ranked)
+{
+  PhaseTimer timer("output");
+  out.write("\nThe ");
+  out.write(static_cast<long long>(ranked.size()));
+  out.write(" fastest schedules:\n");
+  for (int r=0; r<ranked.size(); r++)
+  {
+    out.write("\nSchedule ");
+    out.write(static_cast<long long>(r + 1));
+    out.write(" takes ");
+    out.write(ranked[r].total());
+    if (ranked[r].rounds() > 0)
+    {
+      out.write(" (rounds ");
+      out.write(roundDecisions(ranked[r]).c_str());
+      out.put(')');
+    }
+    out.write(":\n");
+    for (Schedule::Iterator it = ranked[r].begin(); it != ranked[r].end(); ++it)
+    {
+      (*it).write(out, ranked[r].people());
+      out.put('\n');
+    }
+  }
+} // end writeRankedSchedules()
+
+
+// Write a schedule to a file in the binary format.
+// Returns false (with a message) if the file can't be written.
+bool writeScheduleFile(std::string filename, const Schedule& schedule)
+{
+  PhaseTimer timer("output");
+  std::FILE * file = std::fopen(filename.c_str(), "wb");
+  if (file == nullptr)
+  {
+    std::cout << "Error: cannot write " << filename << std::endl;
+    return false;
+  }
+
+  {
+    BufferedWriter out(file);
+    ScheduleEncoder encoder(out);
+    encoder.writeSchedule(schedule);
+  }
+
+  bool ok = (std::ferror(file) == 0);
+  ok = (std::fclose(file) == 0) && ok;
+  if (!ok)
+  {
+    std::cout << "Error: cannot write " << filename << std::endl;
+  }
+  return ok;
+} // end writeScheduleFile()
+
+
+// One strategy's result, for the machine-readable output
+struct StrategyResult
+{
+  const char * name;
+  long long total;
+  long long nanoseconds; // time spent computing it
+  std::string error;     // why it has no total, or ""
+};
+
+
+// Write the --stats report as a JSON object.  It is written as part of the
+// output, so the output phase itself is not included.
+void writeJsonStats(JsonWriter& json, bool ndjson)
+{
+  const Stats& stats = Stats::global();
+  json.beginObject();
+  if (ndjson)
+  {
+    json.key("type");
+    json.value("stats");
+  }
+  json.key("phases");
+  json.beginArray();
+  for (int i=0; i<stats.allPhases().size(); i++)
+  {
+    const Stats::Phase& phase = stats.allPhases()[i];
+    json.beginObject();
+    json.key("name");
+    json.value(phase.name);
+    json.key("nanoseconds");
+    json.value(phase.nanoseconds);
+    json.key("allocations");
+    json.value(static_cast<long long>(phase.allocations));
+    json.key("allocatedBytes");
+    json.value(static_cast<long long>(phase.allocatedBytes));
+    if (stats.perfCountersEnabled())
+    {
+      // Counters the system lacks are left out
+      const char * keys[PERF_COUNTERS] = {"cycles", "instructions", "cacheMisses", "branchMisses"};
+      for (int c=0; c<PERF_COUNTERS; c++)
+      {
+        if (stats.perfCounters().available(c))
+        {
+          json.key(keys[c]);
+          json.value(static_cast<long long>(phase.counters[c]));
+        }
+      }
+    }
+    json.endObject();
+  }
+  json.endArray();
+  if (stats.perfCountersRequested())
+  {
+    json.key("perfCounters");
+    json.value(stats.perfCountersEnabled());
+  }
+  json.key("nanoseconds");
+  json.value(stats.elapsedNanoseconds());
+  json.key("allocations");
+  json.value(static_cast<long long>(allocationCount.load()));
+  json.key("bytesRead");
+  json.value(static_cast<long long>(stats.bytesRead()));
+  json.key("bytesWritten");
+  json.value(static_cast<long long>(stats.bytesWritten()));
+  json.key("people");
+  json.value(stats.peopleCount());
+  json.key("peoplePerSecond");
+  json.value(static_cast<long long>(stats.peoplePerSecond()));
+  json.endObject();
+} // end writeJsonStats()
+
+
+// Write the results as one JSON object, or for NDJSON as one object per
+// line: a line per strategy, then the count of optimal schedules
+// (--count-optimal), a line per ranked schedule (--top-k), and a line per
+// step of the schedule.  schedule may be nullptr when there
+// is none (streamed input).
+void writeJsonResults(const Arguments& args, long long people,
+                      const std::vector<StrategyResult>& results,
+                      const Schedule * schedule,
+                      const std::vector<Schedule>& ranked,
+                      const std::string& optimalCount)
+{
+  PhaseTimer timer("output");
+  BufferedWriter out(stdout);
+  JsonWriter json(out);
+  bool ndjson = (args.format == "ndjson");
+  bool steps = args.showSchedule && schedule != nullptr;
+
+  if (!ndjson)
+  {
+    json.beginObject();
+    json.key("people");
+    json.value(people);
+    json.key("strategies");
+    json.beginArray();
+  }
+  for (int i=0; i<results.size(); i++)
+  {
+    json.beginObject();
+    if (ndjson)
+    {
+      json.key("type");
+      json.value("strategy");
+      json.key("people");
+      json.value(people);
+    }
+    json.key("name");
+    json.value(results[i].name);
+    if (results[i].error != "")
+    {
+      json.key("error");
+      json.value(results[i].error.c_str());
+    }
+    else
+    {
+      json.key("total");
+      json.value(results[i].total);
+      json.key("nanoseconds");
+      json.value(results[i].nanoseconds);
+    }
+    json.endObject();
+    if (ndjson)
+    {
+      json.endLine();
+    }
+  }
+
+  if (args.torchLimit >= 0)
+  {
+    // Crossing is feasible if the optimal total fits the torch
+    long long optimal = 0;
+    for (int i=0; i<results.size(); i++)
+    {
+      if (std::strcmp(results[i].name, "optimal") == 0)
+      {
+        optimal = results[i].total;
+      }
+    }
+    if (!ndjson)
+    {
+      json.endArray();
+      json.key("torch");
+    }
+    json.beginObject();
+    if (ndjson)
+    {
+      json.key("type");
+      json.value("torch");
+    }
+    json.key("limit");
+    json.value(args.torchLimit);
+    json.key("feasible");
+    json.value(optimal <= args.torchLimit);
+    json.endObject();
+    if (ndjson)
+    {
+      json.endLine();
+    }
+  }
+  else if (!ndjson)
+  {
+    json.endArray();
+  }
+
+  if (optimalCount != "")
+  {
+    // As a string: it can have any number of digits
+    if (ndjson)
+    {
+      json.beginObject();
+      json.key("type");
+      json.value("count");
+    }
+    json.key("optimalSchedules");
+    json.value(optimalCount.c_str());
+    if (ndjson)
+    {
+      json.endObject();
+      json.endLine();
+    }
+  }
+
+  if (!ranked.empty())
+  {
+    if (!ndjson)
+    {
+      json.key("ranked");
+      json.beginArray();
+    }
+    for (int r=0; r<ranked.size(); r++)
+    {
+      json.beginObject();
+      if (ndjson)
+      {
+        json.key("type");
+        json.value("ranked");
+      }
+      json.key("rank");
+      json.value(static_cast<long long>(r + 1));
+      json.key("total");
+      json.value(ranked[r].total());
+      json.key("rounds");
+      json.value(roundDecisions(ranked[r]).c_str());
+      json.endObject();
+      if (ndjson)
+      {
+        json.endLine();
+      }
+    }
+    if (!ndjson)
+    {
+      json.endArray();
+    }
+  }
+
+  if (!ndjson)
+  {
+    if (steps)
+    {
+      json.key("schedule");
+      json.beginArray();
+    }
+  }
+  if (steps)
+  {
+    const std::vector<Person>& roster = schedule->people();
+    for (Schedule::Iterator it = schedule->begin(); it != schedule->end(); ++it)
+    {
+      Step step = *it;
+      json.beginObject();
+      if (ndjson)
+      {
+        json.key("type");
+        json.value("step");
+      }
+      json.key("index");
+      json.value(it.position());
+      json.key("kind");
+      json.value(step.kind == Step::RETURN ? "return" : "cross");
+      json.key("people");
+      json.beginArray();
+      NameRef name = roster[step.first].getNameRef();
+      json.value(name.data, name.length);
+      if (step.second >= 0)
+      {
+        name = roster[step.second].getNameRef();
+        json.value(name.data, name.length);
+      }
+      json.endArray();
+      json.key("time");
+      json.value(static_cast<long long>(step.time));
+      json.key("elapsed");
+      json.value(it.elapsed() + step.time);
+      json.endObject();
+      if (ndjson)
+      {
+        json.endLine();
+      }
+    }
+    if (!ndjson)
+    {
+      json.endArray();
+    }
+  }
+
+  if (args.stats)
+  {
+    if (!ndjson)
+    {
+      json.key("stats");
+    }
+    writeJsonStats(json, ndjson);
+    if (ndjson)
+    {
+      json.endLine();
+    }
+  }
+
+  if (!ndjson)
+  {
+    json.endObject();
+    json.endLine();
+  }
+} // end writeJsonResults()
+
+
+// Nanoseconds since an earlier steady_clock time
+long long nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - start).count();
+}
+
+
+// Expand a binary schedule file back into the text writeOptimalCrossings()
+// prints.
+// Returns false (with a message) if the file is unreadable or malformed.
+bool decodeScheduleFile(std::string filename)
+{
+  MappedFile file;
+  if (!file.open(filename))
+  {
+    return false;
+  }
+
+  ScheduleDecoder decoder(file.begin(), file.end());
+  std::vector<Person> roster;
+  long long steps = 0;
+  if (!decoder.readHeader(roster, steps))
+  {
+    std::cout << "Error: " << filename << " is not a binary schedule" << std::endl;
+    return false;
+  }
+
+  BufferedWriter out(stdout);
+  std::ostringstream line;
+  long long elapsed = 0;
+  std::cout << std::endl;
+  std::cout << "Optimal sequence of bridge crossings:" << std::endl;
+  for (long long k=0; k<steps; k++)
+  {
+    Step step;
+    if (!decoder.readStep(roster.size(), step))
+    {
+      out.flush();
+      std::cout << "Error: " << filename << " step " << k << " is malformed" << std::endl;
+      return false;
+    }
+    elapsed += step.time;
+
+    line.str("");
+    step.print(line, roster);
+    line << std::endl;
+    out.write(line.str());
+  }
+  out.flush();
+
+  std::cout << std::endl;
+  std::cout << "The optimal fastest total time is: " << elapsed << std::endl;
+  return true;
+} // end decodeScheduleFile()
+
+
+// Compute the optimal totals of K independent rosters of N people each.
+// The rosters are laid out column-wise: the speed of person i in roster k is
+// columns[i*K + k], so each row holds one person from every roster and each
+// roster is a "lane".  Every step below is the same operation on all lanes,
+// written as a plain inner loop over k that the vectorizer turns into SIMD
+// min/max/add instructions, so the cost per roster is a few instructions per
+// comparator instead of a full sort and solve.  g++ only vectorizes these
+// loops at -O3 (clang at -O2), hence the --batch build line at the top.
+// The sort and the rounds stay in 32-bit lanes; only the totals are wide.
+// The sorting network is O(N*N) per lane, which is intended for small crews.
+void solveBatch(const int * columns, int N, int K, long long * totals)
+{
+  std::vector<int> lanes(columns, columns + N*K);
+
+  // Sort every lane with the odd-even transposition network, one row pair
+  // at a time
+  for (int pass=0; pass<N; pass++)
+  {
+    for (int i=pass%2; i+1<N; i+=2)
+    {
+      int * upper = &lanes[i*K];
+      int * lower = &lanes[(i+1)*K];
+      for (int k=0; k<K; k++)
+      {
+        int lo = std::min(upper[k], lower[k]);
+        int hi = std::max(upper[k], lower[k]);
+        upper[k] = lo;
+        lower[k] = hi;
+      }
+    }
+  }
+
+  for (int k=0; k<K; k++)
+  {
+    totals[k] = 0;
+  }
+  if (N == 0)
+  {
+    return;
+  }
+
+  // Row 0 holds the fastest person of every lane, row 1 the second fastest
+  const int * fastest = &lanes[0];
+  const int * second = &lanes[(N > 1 ? 1 : 0) * K];
+
+  // The shielding rounds, with a per-lane min-select between the methods
+  int n = N;
+  while (n >= 4)
+  {
+    const int * slowest = &lanes[(n-1)*K];
+    const int * nextSlowest = &lanes[(n-2)*K];
+    for (int k=0; k<K; k++)
+    {
+      totals[k] += laneRoundTime(fastest[k], second[k], slowest[k], nextSlowest[k]);
+    }
+    n -= 2;
+  }
+
+  // Handle the cases where there are 1 to 3 people left
+  const int * third = &lanes[(n > 2 ? 2 : 0) * K];
+  for (int k=0; k<K; k++)
+  {
+    totals[k] += finalTime<long long>(n, fastest[k], second[k], third[k]);
+  }
+} // end solveBatch()
+
+
+// Read a YAML file of equal-sized rosters into column-wise storage for
+// solveBatch().  Returns false (with a message) if the rosters differ in size.
+bool readBatchFile(std::string filename, std::vector<int>& columns, int& N, int& K)
+{
+  // The format of the yaml file is:
+  // rosters:
+  //   - [1, 2, 5, 10]
+  //   - [1, 2, 3, 4]
+
+  YAML::Node batchYAML = YAML::LoadFile(filename);
+  YAML::Node rosters = batchYAML["rosters"];
+
+  K = rosters.size();
+  N = (K > 0) ? rosters[0].size() : 0;
+  columns.assign(N*K, 0);
+
+  for (int k=0; k<K; k++)
+  {
+    if (rosters[k].size() != N)
+    {
+      std::cout << "Error: roster " << k << " has " << rosters[k].size()
+                << " people, but roster 0 has " << N << std::endl;
+      return false;
+    }
+    for (int i=0; i<N; i++)
+    {
+      columns[i*K + k] = rosters[k][i].as<int>();
+    }
+  }
+  return true;
+} // end readBatchFile()
+
+
+// -------------------------------------------------------------------------
+//                             Main Program
+// -------------------------------------------------------------------------
+int main(int argc, char * argv[]) {
+  // Process the command line arguments
+
+  Arguments args;
+  args.getArgs(argc, argv);
+  bool text = (args.format == "text");
+
+  // With --stats, count the bytes written to std::cout until main() returns
+  std::unique_ptr<CountingStreambuf> outputCounter;
+  if (args.stats)
+  {
+    Stats::global().enable();
+    outputCounter.reset(new CountingStreambuf(std::cout));
+  }
+  if (args.perfCounters)
+  {
+    Stats::global().requestPerfCounters();
+  }
+
+  if (text)
+  {
+    std::cout << "Running..." << std::endl;
+  }
+  if (args.help)
+  {
+    args.printHelp();
+  }
+  if (args.abort)
+  {
+    return 0;
+  }
+  if (args.decodeFilename != "")
+  {
+    decodeScheduleFile(args.decodeFilename);
+    return 0;
+  }
+  if (args.batchFilename != "")
+  {
+    std::vector<int> columns;
+    int N, K;
+    if (!readBatchFile(args.batchFilename, columns, N, K))
+    {
+      return 0;
+    }
+    std::vector<long long> totals(K);
+    solveBatch(columns.data(), N, K, totals.data());
+
+    std::cout << std::endl;
+    for (int k=0; k<K; k++)
+    {
+      std::cout << "Roster " << k << " optimal fastest total time: " << totals[k] << std::endl;
+    }
+    return 0;
+  }
+  if (args.peopleFilename == "" && args.dumpFilename == "" && args.csvFilename == "")
+  {
+    std::cout << args.progName << ": ERROR: Missing option peopleFile" << std::endl;
+    return 0;
+  }
+  if (DEBUG==1) {std::cout << "peopleFilename=<" << args.peopleFilename << ">" << std::endl;}
+
+  // We have the arguments, now do the real stuff
+
+  // In online mode people arrive one at a time, from standard input as they
+  // are piped in, or in file order, and the running optimal total is
+  // reported after each arrival.
+  if (args.online)
+  {
+    Bridge arrivalBridge;
+    long long total = 0;
+
+    if (args.peopleFilename == "-")
+    {
+      std::cout << std::endl;
+      PeopleStream stream(std::cin);
+      DumpRecord record;
+      while (stream.next(record))
+      {
+        Person p;
+        p.setName( record.name, record.nameLength );
+        p.setSpeed( record.speed );
+        total = arrivalBridge.arrive(p);
+        std::cout << p << " arrives, " << arrivalBridge.people().size()
+                  << " people waiting, optimal total time: " << total << std::endl;
+      }
+      if (stream.failed())
+      {
+        std::cout << "Error: standard input line " << stream.line() << ": expected a name and a positive speed" << std::endl;
+        return 0;
+      }
+    }
+    else
+    {
+      Bridge loaded;
+      if (!loadPeople(args, loaded))
+      {
+        return 0;
+      }
+
+      std::cout << std::endl;
+      for (int i=0; i<loaded.people().size(); i++)
+      {
+        Person p = loaded.people()[i];
+        total = arrivalBridge.arrive(p);
+        std::cout << p << " arrives, " << arrivalBridge.people().size()
+                  << " people waiting, optimal total time: " << total << std::endl;
+      }
+    }
+
+    std::cout << std::endl;
+    std::cout << "The optimal fastest total time is: " << total << std::endl;
+    return 0;
+  }
+
+  // "--people -" streams a roster dump from standard input.  The people are
+  // only counted by speed, never stored, so there is no schedule to print.
+  if (args.peopleFilename == "-")
+  {
+    PeopleStream stream(std::cin);
+    SpeedHistogram histogram;
+    DumpRecord record;
+    {
+      PhaseTimer timer("load");
+      while (stream.next(record))
+      {
+        histogram.add(record.speed);
+      }
+    }
+    if (stream.failed())
+    {
+      std::cout << "Error: standard input line " << stream.line() << ": expected a name and a positive speed" << std::endl;
+      return 0;
+    }
+    Stats::global().setPeople(histogram.size());
+
+    std::vector<StrategyResult> results(2);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+      PhaseTimer timer("naive");
+      results[0].name = "naive";
+      results[0].total = histogram.naiveTotal();
+      results[0].nanoseconds = nanosecondsSince(start);
+    }
+    start = std::chrono::steady_clock::now();
+    {
+      PhaseTimer timer("optimal");
+      results[1].name = "optimal";
+      results[1].total = histogram.optimalTotal();
+      results[1].nanoseconds = nanosecondsSince(start);
+    }
+
+    if (!text)
+    {
+      writeJsonResults(args, histogram.size(), results, nullptr, std::vector<Schedule>(), "");
+      return 0;
+    }
+
+    {
+      PhaseTimer timer("output");
+      std::cout << std::endl;
+      std::cout << "Read " << histogram.size() << " people from standard input" << std::endl;
+      std::cout << std::endl;
+      std::cout << "The naive fastest total time is: " << results[0].total << std::endl;
+      std::cout << std::endl;
+      std::cout << "The optimal fastest total time is: " << results[1].total << std::endl;
+    }
+    if (args.torchLimit >= 0)
+    {
+      BufferedWriter out(stdout);
+      writeTorchLimit(out, args.torchLimit, results[1].total);
+    }
+    if (args.stats)
+    {
+      Stats::global().print(std::cout);
+    }
+    return 0;
+  }
+
+  Bridge narrowBridge;
+
+  if (!loadPeople(args, narrowBridge))
+  {
+    return 0;
+  }
+  Stats::global().setPeople(narrowBridge.people().size());
+
+  // Machine-readable output: time each strategy, and write no prose
+  if (!text)
+  {
+    std::vector<StrategyResult> results(2);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    results[0].name = "naive";
+    results[0].total = narrowBridge.naiveTotal();
+    results[0].nanoseconds = nanosecondsSince(start);
+    // The optimal total alone, which small rosters get from solveSmall<N>()
+    // without sorting or allocating.  The schedule comes after it, since
+    // --schedule and the strategies below need it and the people sorted.
+    start = std::chrono::steady_clock::now();
+    results[1].name = "optimal";
+    results[1].total = narrowBridge.optimalTotal();
+    results[1].nanoseconds = nanosecondsSince(start);
+    Schedule schedule = narrowBridge.planOptimally();
+    if (args.scheduleFilename != "")
+    {
+      writeScheduleFile(args.scheduleFilename, schedule);
+    }
+    if (args.exact != "")
+    {
+      // A roster too big to search gets the reason in place of a total, so
+      // the output stays one JSON document
+      start = std::chrono::steady_clock::now();
+      StrategyResult result;
+      result.name = "exact";
+      result.error = exactSearchLimit(args, CrossingStates(CrossingSearch::speedsOf(schedule)));
+      if (result.error == "")
+      {
+        result.total = searchExactly(args, schedule).total;
+      }
+      result.nanoseconds = nanosecondsSince(start);
+      results.push_back(result);
+    }
+    if (narrowBridge.isConstrained())
+    {
+      start = std::chrono::steady_clock::now();
+      ConstrainedPlan plan = narrowBridge.planConstrained(args.ttSize << 20);
+      if (plan.isFound())
+      {
+        StrategyResult result;
+        result.name = "constrained";
+        result.total = plan.total();
+        result.nanoseconds = nanosecondsSince(start);
+        results.push_back(result);
+      }
+    }
+    if (args.pairPenalty >= 0 || args.pairTable != "")
+    {
+      start = std::chrono::steady_clock::now();
+      PairCostResult pairCost;
+      if (!solvePairCost(args, narrowBridge.people(), pairCost))
+      {
+        return 0;
+      }
+      StrategyResult result;
+      result.name = "pair-cost";
+      result.total = pairCost.total;
+      result.nanoseconds = nanosecondsSince(start);
+      results.push_back(result);
+    }
+    if (args.maxLoad >= 0)
+    {
+      start = std::chrono::steady_clock::now();
+      LoadPlan plan = narrowBridge.planLoad(args.maxLoad);
+      if (plan.isFeasible())
+      {
+        StrategyResult result;
+        result.name = "load";
+        result.total = plan.total();
+        result.nanoseconds = nanosecondsSince(start);
+        results.push_back(result);
+      }
+    }
+    if (args.bridges > 1)
+    {
+      // The makespan across the bridges, as one more strategy
+      start = std::chrono::steady_clock::now();
+      Partition partition = narrowBridge.planBridges(args.bridges);
+      StrategyResult result;
+      result.name = "bridges";
+      result.total = partition.makespan();
+      result.nanoseconds = nanosecondsSince(start);
+      results.push_back(result);
+    }
+    if (args.torches > 1)
+    {
+      start = std::chrono::steady_clock::now();
+      TorchPlan plan = narrowBridge.planTorches(args.torches);
+      StrategyResult result;
+      result.name = "torches";
+      result.total = plan.total();
+      result.nanoseconds = nanosecondsSince(start);
+      results.push_back(result);
+    }
+
+    std::vector<Schedule> ranked;
+    if (args.topK > 0)
+    {
+      ranked = rankSchedules(schedule, args.topK);
+    }
+    std::string optimalCount;
+    if (args.countOptimal)
+    {
+      optimalCount = countOptimalSchedules(schedule).str();
+    }
+    writeJsonResults(args, narrowBridge.people().size(), results, &schedule, ranked, optimalCount);
+    return 0;
+  }
+
+  // For comparison, do both the Naive and Shielding methods.  The solvers
+  // only compute; the text goes out through one buffered writer.  The people
+  // are listed and the Naive crossings written in input order, before
+  // planOptimally() sorts them.
+  {
+    BufferedWriter out(stdout);
+    if (args.listPeople)
+    {
+      writePeopleList(out, narrowBridge.people());
+    }
+
+    writeNaiveCrossings(out, narrowBridge.people(), narrowBridge.fastestIndex());
+    out.write("\nThe naive fastest total time is: ");
+    out.write(narrowBridge.naiveTotal());
+    out.put('\n');
+
+    Schedule schedule = narrowBridge.planOptimally();
+    writeOptimalCrossings(out, schedule);
+    out.write("\nThe optimal fastest total time is: ");
+    out.write(schedule.total());
+    out.put('\n');
+    out.flush();
+
+    if (args.scheduleFilename != "")
+    {
+      writeScheduleFile(args.scheduleFilename, schedule);
+    }
+
+    if (narrowBridge.isConstrained())
+    {
+      writeConstrainedCrossings(out, narrowBridge.planConstrained(args.ttSize << 20), narrowBridge.across());
+    }
+
+    if (args.pairPenalty >= 0 || args.pairTable != "")
+    {
+      // Errors go straight to std::cout, after what is already written
+      out.flush();
+      PairCostResult pairCost;
+      if (solvePairCost(args, narrowBridge.people(), pairCost))
+      {
+        if (pairCost.exactError != "")
+        {
+          std::cout << "Error: " << pairCost.exactError << std::endl;
+        }
+        writePairCostCrossings(out, narrowBridge.people(), pairCost);
+      }
+    }
+
+    if (args.maxLoad >= 0)
+    {
+      writeLoadCrossings(out, narrowBridge.planLoad(args.maxLoad));
+    }
+
+    if (args.countOptimal)
+    {
+      BigNatural count = countOptimalSchedules(schedule);
+      out.write("\nThe number of optimal schedules is: ");
+      out.write(count.str().c_str());
+      out.put('\n');
+    }
+
+    if (args.topK > 0)
+    {
+      writeRankedSchedules(out, rankSchedules(schedule, args.topK));
+    }
+
+    if (args.torchLimit >= 0)
+    {
+      writeTorchLimit(out, args.torchLimit, schedule.total());
+    }
+
+    if (args.exact != "")
+    {
+      // exactSearchFits() writes its error straight to std::cout
+      out.flush();
+      if (exactSearchFits(args, schedule))
+      {
+        ExactResult result = searchExactly(args, schedule);
+        writeExactSearch(out, narrowBridge.people(), result);
+      }
+    }
+
+    if (args.bridges > 1)
+    {
+      Partition partition = narrowBridge.planBridges(args.bridges);
+      writeBridgePartition(out, narrowBridge.people(), partition);
+    }
+
+    if (args.torches > 1)
+    {
+      writeTorchCrossings(out, narrowBridge.planTorches(args.torches));
+    }
+  }
+
+  if (args.stats)
+  {
+    Stats::global().print(std::cout);
+  }
 
   return 0;
 }
@@ -0,0 +1,237 @@
+/*
+This program checks the exact searches under a pair cost against brute
+force.  Every roster is solved by a shortest-path search over each set of
+people on the near bank, with the torch on either side, trying every pair
+and every person alone.  Each of --exact dfs, parallel and ida must then
+find the same total with a valid schedule.
+
+The first rosters are ones the searches once got wrong, when only the last
+person on the near bank could cross alone.  The rest are random, with
+random tables that make some pairs faster and some slower than their pace.
+
+To compile and run, from the top directory:
+% g++ -std=c++11 -pthread -o pair-cost-check tests/pair-cost-check.cpp -lyaml-cpp
+% ./pair-cost-check
+*/
+
+#define main crossBridgeMain
+#include "../cross-bridge.cpp"
+#undef main
+
+#include <random>
+
+const int CHECK_PEOPLE_MAX = 8;
+
+// The least total time for sorted speeds under the cost, by brute force.
+// A state is the near-bank set shifted left once, with the torch in bit 0.
+template <typename Cost>
+long long bruteForceTotal(const std::vector<int>& speeds, const Cost& cost)
+{
+  int n = speeds.size();
+  int states = 2 << n;
+  std::vector<long long> best(states, UNREACHABLE_TIME);
+  std::vector<bool> done(states, false);
+  int start = (((1 << n) - 1) << 1) | 1;
+  best[start] = 0;
+
+  for (;;)
+  {
+    int state = -1;
+    for (int s=0; s<states; s++)
+    {
+      if (!done[s] && best[s] < UNREACHABLE_TIME && (state < 0 || best[s] < best[state]))
+      {
+        state = s;
+      }
+    }
+    if (state < 0)
+    {
+      return UNREACHABLE_TIME;
+    }
+    if (state == 0)
+    {
+      return best[0];
+    }
+    done[state] = true;
+
+    int near = state >> 1;
+    for (int i=0; i<n; i++)
+    {
+      if ((state & 1) == 0)
+      {
+        // Anyone on the far bank brings the torch back
+        if ((near & (1 << i)) == 0)
+        {
+          int next = ((near | (1 << i)) << 1) | 1;
+          best[next] = std::min(best[next], best[state] + speeds[i]);
+        }
+        continue;
+      }
+      if ((near & (1 << i)) == 0)
+      {
+        continue;
+      }
+      // i alone, or with j, who is no faster
+      for (int j=i; j<n; j++)
+      {
+        if ((near & (1 << j)) == 0)
+        {
+          continue;
+        }
+        long long time = (j == i) ? speeds[i] : cost(speeds[i], speeds[j]);
+        int next = (near & ~(1 << i) & ~(1 << j)) << 1;
+        best[next] = std::min(best[next], best[state] + time);
+      }
+    }
+  }
+} // end bruteForceTotal()
+
+
+// Whether the steps take everyone across, each with the torch, in the
+// times the cost says, and add up to total
+template <typename Cost>
+bool isValid(const std::vector<int>& speeds, const std::vector<Step>& steps,
+             long long total, const Cost& cost)
+{
+  std::vector<bool> near(speeds.size(), true);
+  bool torchNear = true;
+  long long sum = 0;
+  for (int k=0; k<steps.size(); k++)
+  {
+    const Step& step = steps[k];
+    int time = speeds[step.first];
+    if (step.kind == Step::CROSS)
+    {
+      if (!torchNear || !near[step.first])
+      {
+        return false;
+      }
+      near[step.first] = false;
+      if (step.second >= 0)
+      {
+        if (!near[step.second])
+        {
+          return false;
+        }
+        near[step.second] = false;
+        time = cost(std::min(speeds[step.first], speeds[step.second]),
+                    std::max(speeds[step.first], speeds[step.second]));
+      }
+    }
+    else
+    {
+      if (torchNear || near[step.first])
+      {
+        return false;
+      }
+      near[step.first] = true;
+    }
+    if (step.time != time)
+    {
+      return false;
+    }
+    torchNear = !torchNear;
+    sum += time;
+  }
+  return std::find(near.begin(), near.end(), true) == near.end() && sum == total;
+} // end isValid()
+
+
+// Run each exact search on the roster and count the ones that disagree
+// with brute force
+template <typename Cost>
+int checkRoster(std::vector<int> speeds, const Cost& cost)
+{
+  std::sort(speeds.begin(), speeds.end());
+  long long truth = bruteForceTotal(speeds, cost);
+  std::vector<Step> rounds = planPairRounds(speeds, cost);
+
+  const char * engines[3] = {"dfs", "parallel", "ida"};
+  int failures = 0;
+  for (int e=0; e<3; e++)
+  {
+    Arguments args;
+    args.exact = engines[e];
+    args.threads = 2;
+    args.ttSize = 1;
+    CrossingStates states(speeds);
+    states.setPairCost(cost);
+    ExactResult result = searchStates(args, states, rounds);
+    if (result.total != truth || !isValid(speeds, result.steps, result.total, cost))
+    {
+      std::cout << "FAIL --exact " << engines[e] << " speeds";
+      for (int i=0; i<speeds.size(); i++)
+      {
+        std::cout << ' ' << speeds[i];
+      }
+      std::cout << ": " << result.total << ", brute force " << truth << std::endl;
+      failures++;
+    }
+  }
+  return failures;
+} // end checkRoster()
+
+
+int main()
+{
+  int failures = 0;
+  int rosters = 0;
+
+  // A=1, B=5, C=1: B crosses alone between two trips of A and C
+  {
+    TableCost table;
+    table.set(1, 1, 2);
+    table.set(1, 5, 11);
+    int speeds[3] = {1, 5, 1};
+    failures += checkRoster(std::vector<int>(speeds, speeds + 3), table);
+    rosters++;
+  }
+
+  // Speeds 1 and 1 cross together in a minute, but 1 and 3 take twice as
+  // long as 3 alone
+  {
+    TableCost table;
+    table.set(1, 1, 1);
+    table.set(1, 3, 6);
+    int speeds[5] = {10, 1, 15, 1, 3};
+    failures += checkRoster(std::vector<int>(speeds, speeds + 5), table);
+    rosters++;
+  }
+
+  std::mt19937 random(2026);
+  for (int r=0; r<300; r++)
+  {
+    int n = 1 + random() % CHECK_PEOPLE_MAX;
+    std::vector<int> speeds(n);
+    for (int i=0; i<n; i++)
+    {
+      speeds[i] = 1 + random() % 20;
+    }
+
+    if (r % 3 == 0)
+    {
+      failures += checkRoster(speeds, PenaltyCost(random() % 6));
+    }
+    else
+    {
+      // Some pairs anywhere from far faster to twice as slow as their pace
+      TableCost table;
+      for (int i=0; i<n; i++)
+      {
+        for (int j=i; j<n; j++)
+        {
+          if (random() % 2 == 0)
+          {
+            int slow = std::max(speeds[i], speeds[j]);
+            table.set(speeds[i], speeds[j], 1 + random() % (2 * slow));
+          }
+        }
+      }
+      failures += checkRoster(speeds, table);
+    }
+    rosters++;
+  }
+
+  std::cout << rosters << " rosters checked, " << failures << " failures" << std::endl;
+  return failures == 0 ? 0 : 1;
+} // end main()